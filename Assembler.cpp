@@ -1,341 +1,925 @@
 #include "Assembler.hpp"
 #include <fstream>
-#include <iostream>
 #include <algorithm>
+#include <charconv>
+#include <memory>
+#include "Parallel.hpp"
+#include "TextScan.hpp"
+
+namespace
+{
+    bool is_number(string_view s)
+    {
+        return !s.empty() && all_of(s.begin(), s.end(), [](char c)
+                                    { return isdigit(static_cast<unsigned char>(c)) != 0; });
+    }
+
+    // Converte um literal decimal já validado (só dígitos) sem criar string.
+    // Falha se o valor não cabe em um int.
+    bool parse_number(string_view s, int &value)
+    {
+        value = 0;
+        auto result = from_chars(s.data(), s.data() + s.size(), value);
+        return result.ec == errc();
+    }
+}
 
 void Assembler::assemble(const string &input_filename, const string &o1_filename, const string &o2_filename)
 {
-    initialize_optab();
-    pass(input_filename);
+    FileLineSource input(input_filename);
+    assemble(input, o1_filename, o2_filename);
+}
+
+void Assembler::assemble(LineSource &input, const string &o1_filename, const string &o2_filename)
+{
+    reset();
+    pass(input);
+    if (optimizing && !checkOnly)
+        optimize();
+    write_outputs(o1_filename, o2_filename);
+}
 
-    if (!errors.empty())
+void Assembler::reset()
+{
+    locCounter = 0;
+    lineNumber = 0;
+    pendingDefinition.clear();
+    currentLabel.clear();
+    deferred = false;
+    predefined = nullptr;
+    startPending.clear();
+    events.clear();
+    symtab.clear();
+    codigoObjeto.clear();
+    backpatches.clear();
+    fixups.clear();
+    relocations.clear();
+    diagnostics.clear();
+    diagnosticText.clear();
+    formattedErrors.clear();
+    errorsFormatted = false;
+    aborted = false;
+    codeItems.clear();
+    symbolRefs.clear();
+    hasImmediate = false;
+    optimizationReport = PeepholeReport();
+    assembledLines = 0;
+    tokenCount = 0;
+    longestLine = 0;
+    lineTime = {};
+    tokenizeTime = {};
+    lineHeap = {};
+    tokenizeHeap = {};
+    cpuTime = 0;
+}
+
+void Assembler::feed(string_view inputLine)
+{
+    if (aborted)
+        return;
+    if (timing)
+        timed_line(inputLine);
+    else
+        assemble_line(inputLine);
+}
+
+void Assembler::finish()
+{
+    if (timing)
     {
-        cout << "Erros encontrados durante a montagem:\n";
-        for (const auto &err : errors)
-        {
-            cout << "Linha " << err.first << ": " << err.second << endl;
-        }
+        auto start = chrono::steady_clock::now();
+        AllocationCount heapStart = thread_allocations();
+        finish_pass();
+        lineTime += chrono::steady_clock::now() - start;
+        lineHeap += thread_allocations() - heapStart;
+        collect_stats();
+    }
+    else
+    {
+        finish_pass();
+    }
+    if (optimizing && !checkOnly)
+        optimize();
+}
+
+void Assembler::object_code_o1(vector<int> &out) const
+{
+    out.assign(codigoObjeto.begin(), codigoObjeto.end());
+    for (const Backpatch &patch : backpatches)
+        out[patch.slot] = patch.original;
+}
+
+// Registra um erro da linha `line`; a mensagem só é montada na impressão.
+// Acima do limite de --max-errors o erro é descartado e a passagem para.
+void Assembler::report(DiagCode code, int line, string_view detail, int symbol)
+{
+    if (maxErrors != 0 && diagnostics.size() >= maxErrors)
+        return;
+    diagnostics.push_back({code, line, symbol, static_cast<uint32_t>(diagnosticText.size()),
+                           static_cast<uint32_t>(detail.size())});
+    diagnosticText.append(detail);
+    errorsFormatted = false;
+    if (maxErrors != 0 && diagnostics.size() >= maxErrors)
+        aborted = true;
+}
+
+string Assembler::message(const Diagnostic &diagnostic) const
+{
+    string_view detail = diagnostic.symbol >= 0
+                             ? symtab.name(diagnostic.symbol)
+                             : string_view(diagnosticText).substr(diagnostic.detailBegin, diagnostic.detailLength);
+    return diagnostic_message(diagnostic.code, detail);
+}
+
+const vector<pair<int, string>> &Assembler::getErrors() const
+{
+    if (!errorsFormatted)
+    {
+        formattedErrors.clear();
+        for (const Diagnostic &diagnostic : diagnostics)
+            formattedErrors.push_back({diagnostic.line, message(diagnostic)});
+        errorsFormatted = true;
+    }
+    return formattedErrors;
+}
+
+void Assembler::report_errors()
+{
+    if (diagnostics.empty())
+        return;
+    LOG_ERROR(log, "Erros encontrados durante a montagem:");
+    for (const Diagnostic &diagnostic : diagnostics)
+    {
+        LOG_ERROR(log, "Linha " << diagnostic.line << ": " << message(diagnostic));
+    }
+    if (aborted)
+    {
+        LOG_ERROR(log, "Limite de " << maxErrors << " erro(s) atingido (--max-errors); os seguintes nao foram verificados.");
+    }
+}
+
+void Assembler::write_outputs(const string &o1_filename, const string &o2_filename)
+{
+    PhaseClock clock(stats ? &stats->write : nullptr);
+    report_errors();
+    if (checkOnly)
+    {
+        LOG_INFO(log, "Modo de verificacao: nenhum arquivo objeto gerado.");
+        return;
+    }
+    // O resto do programa não foi lido: um objeto gravado agora estaria
+    // truncado e substituiria o anterior como se fosse válido.
+    if (aborted)
+    {
+        LOG_INFO(log, "Montagem interrompida no limite de erros: nenhum arquivo objeto gerado.");
+        return;
     }
     generate_o1_file(o1_filename);
     generate_o2_file(o2_filename);
+    if (!binary_filename.empty())
+    {
+        LOG_INFO(log, "Gerando arquivo objeto binario: " << binary_filename);
+        write_binary_object(binary_filename, object_image());
+    }
 }
 
-void Assembler::initialize_optab()
+ObjectImage Assembler::object_image() const
 {
-    optab["ADD"] = {1, 2, 1};
-    optab["SUB"] = {2, 2, 1};
-    optab["MULT"] = {3, 2, 1};
-    optab["DIV"] = {4, 2, 1};
-    optab["JMP"] = {5, 2, 1};
-    optab["JMPN"] = {6, 2, 1};
-    optab["JMPP"] = {7, 2, 1};
-    optab["JMPZ"] = {8, 2, 1};
-    optab["COPY"] = {9, 3, 2};
-    optab["LOAD"] = {10, 2, 1};
-    optab["STORE"] = {11, 2, 1};
-    optab["INPUT"] = {12, 2, 1};
-    optab["OUTPUT"] = {13, 2, 1};
-    optab["STOP"] = {14, 1, 0};
+    ObjectImage image;
+    image.words = codigoObjeto;
+    // Agrupa as pendências que sobraram por símbolo, na ordem de aparição.
+    vector<int> chainOf(symtab.size(), -1);
+    for (size_t i = 0; i < fixups.size(); i++)
+    {
+        int id = fixups.symbol[i];
+        if (symtab[id].isDefined)
+            continue;
+        if (chainOf[id] < 0)
+        {
+            chainOf[id] = static_cast<int>(image.pending.size());
+            image.pending.push_back({string(symtab.name(id)), {}});
+        }
+        image.pending[chainOf[id]].sites.push_back({fixups.slot[i], fixups.offset[i]});
+    }
+    for (int id = 0; id < static_cast<int>(symtab.size()); id++)
+    {
+        if (symtab[id].isPublic && symtab[id].isDefined)
+            image.definitions.push_back({string(symtab.name(id)), symtab[id].address});
+    }
+    for (int slot : relocations)
+        image.markRelocated(static_cast<size_t>(slot));
+    // A lista encadeada do .o1 vai da referência mais recente para a mais antiga.
+    for (PendingChain &chain : image.pending)
+    {
+        reverse(chain.sites.begin(), chain.sites.end());
+    }
+    return image;
 }
 
-void Assembler::pass(const string &input_filename)
+void Assembler::pass(LineSource &input)
 {
-    ifstream input_file(input_filename);
-    if (!input_file.is_open())
+    string_view inputLine;
+    if (!timing)
     {
-        throw runtime_error("Erro ao abrir o arquivo de entrada: " + input_filename);
+        while (!aborted && input.next(inputLine))
+        {
+            assemble_line(inputLine);
+        }
+        finish_pass();
+        return;
+    }
+
+    // Com --stats só conta o tempo dentro de assemble_line/finish_pass, não a
+    // espera pelo pré-processador.
+    double cpuStart = thread_cpu_seconds();
+    while (!aborted && input.next(inputLine))
+    {
+        timed_line(inputLine);
     }
+    auto start = chrono::steady_clock::now();
+    AllocationCount heapStart = thread_allocations();
+    finish_pass();
+    lineTime += chrono::steady_clock::now() - start;
+    lineHeap += thread_allocations() - heapStart;
+    cpuTime += thread_cpu_seconds() - cpuStart;
+    collect_stats();
+}
 
-    string line;
-    int locCounter = 0;
-    int lineNumber = 0;
-    string pendingDefinition = "";
+void Assembler::timed_line(string_view inputLine)
+{
+    auto start = chrono::steady_clock::now();
+    AllocationCount heapStart = thread_allocations();
+    assemble_line(inputLine);
+    lineTime += chrono::steady_clock::now() - start;
+    lineHeap += thread_allocations() - heapStart;
+}
+
+// Divide o tempo da passagem entre tokenização e codificação e preenche os
+// contadores. Chamado no fim da passagem, antes de gravar os objetos.
+void Assembler::collect_stats()
+{
+    double lineSeconds = chrono::duration<double>(lineTime).count();
+    double tokenizeSeconds = chrono::duration<double>(tokenizeTime).count();
+    double share = lineSeconds > 0 ? tokenizeSeconds / lineSeconds : 0;
+    stats->tokenize += {tokenizeSeconds, cpuTime * share, tokenizeHeap};
+    stats->encode += {lineSeconds - tokenizeSeconds, cpuTime * (1 - share), lineHeap - tokenizeHeap};
+
+    stats->assembledLines += assembledLines;
+    stats->tokens += tokenCount;
+    stats->longestLine = max(stats->longestLine, longestLine);
+    stats->symbols += symtab.size();
+    stats->forwardReferences += fixups.size();
+    vector<size_t> chainLength(symtab.size(), 0);
+    for (size_t i = 0; i < fixups.size(); i++)
+    {
+        size_t length = ++chainLength[fixups.symbol[i]];
+        if (length == 1)
+            stats->fixupChains++;
+        stats->longestFixupChain = max(stats->longestFixupChain, length);
+    }
+    stats->objectWords += codigoObjeto.size();
+    stats->errors += diagnostics.size();
+}
+
+void Assembler::assemble_line(string_view inputLine)
+{
+    lineNumber++;
+    assembledLines++;
+    longestLine = max(longestLine, inputLine.size());
+    // Linhas do pré-processador já vêm em maiúsculas; as demais são
+    // convertidas numa cópia. Linhas vazias e comentários saem do scan sem
+    // tokens.
+    string_view line = inputLine;
+    if (!foldedInput)
+    {
+        upperLine.assign(inputLine);
+        fold_upper(upperLine.data(), upperLine.size());
+        line = upperLine;
+    }
+    LexicalError lexicalError;
+    bool scanned;
+    if (timing)
+    {
+        auto start = chrono::steady_clock::now();
+        AllocationCount heapStart = thread_allocations();
+        scanned = lexicalAnalyzer.scan(line, lineNumber, tokens, lexicalError);
+        tokenizeTime += chrono::steady_clock::now() - start;
+        tokenizeHeap += thread_allocations() - heapStart;
+    }
+    else
+    {
+        scanned = lexicalAnalyzer.scan(line, lineNumber, tokens, lexicalError);
+    }
+    if (!scanned)
+    {
+        report(lexicalError.code, lineNumber, lexicalError.text);
+        return;
+    }
+    tokenCount += tokens.size();
+    if (tokens.empty())
+    {
+        return;
+    }
+    size_t tokenIndex = 0;
+    currentLabel = pendingDefinition;
 
-    while (getline(input_file, line))
+    if (tokens[0].type == TokenType::LABEL)
     {
-        lineNumber++;
-        for (char &c : line)
+        if (!currentLabel.empty())
         {
-            c = toupper(static_cast<unsigned char>(c));
+            report(DiagCode::TWO_LABELS, lineNumber);
+            return;
         }
+        currentLabel.assign(tokens[0].value);
+        tokenIndex++;
+    }
 
-        try
+    if (!currentLabel.empty())
+    {
+        // Se a linha não tem instrução (só rótulo),
+        // seta como pendente e espera a definição real
+        // de uma instrução na mesma linha ou em uma linha seguinte
+        // Caso: ROTULO:
+        //         ADD N1
+        if (tokenIndex >= tokens.size())
         {
-            vector<Token> tokens;
-            if (line.empty() || all_of(line.begin(), line.end(), [](char c)
-                                       { return isspace(static_cast<unsigned char>(c)); }) ||
-                line[0] == ';')
-            {
-                continue; // Pula linhas vazias ou comentários
-            }
-            tokens = lexicalAnalyzer.tokenize(line, lineNumber);
-            if (tokens.empty())
-            {
-                continue;
-            }
-            size_t tokenIndex = 0;
-            std::string currentLabel = pendingDefinition;
+            pendingDefinition = currentLabel;
+            return;
+        }
 
-            if (tokens[0].type == TokenType::LABEL)
-            {
-                if (!currentLabel.empty())
-                {
-                    throw std::runtime_error("Dois rotulos na mesma linha.");
-                }
-                currentLabel = tokens[0].value;
-                tokenIndex++;
-            }
+        // Se não, define o rótulo agora (instrução segue na mesma linha)
+        // Caso: ROTULO: ADD N1
+        int labelId = symtab.find(currentLabel);
+        bool isExtern = labelId >= 0 && symtab[labelId].isExtern;
+        if (!isExtern && predefined)
+        {
+            int previousId = predefined->find(currentLabel);
+            isExtern = previousId >= 0 && (*predefined)[previousId].isExtern;
+        }
+        if (is_defined(currentLabel))
+        {
+            report(DiagCode::DUPLICATE_LABEL, lineNumber, currentLabel);
+            return;
+        }
+        if (isExtern)
+        {
+            report(DiagCode::EXTERN_DEFINED, lineNumber, currentLabel);
+            return;
+        }
 
-            if (!currentLabel.empty())
-            {
-                // Se a linha não tem instrução (só rótulo),
-                // seta como pendente e espera a definição real
-                // de uma instrução na mesma linha ou em uma linha seguinte
-                // Caso: ROTULO:
-                //         ADD N1
-                if (tokenIndex >= tokens.size())
-                {
-                    pendingDefinition = currentLabel;
-                    continue;
-                }
+        // Adiciona ou atualiza o rótulo na Tabela de Símbolos (SYMTAB)
+        if (labelId < 0)
+        {
+            labelId = symtab.intern(currentLabel);
+        }
+        if (deferred)
+        {
+            SymbolItem &label = symtab[labelId];
+            label.address = locCounter;
+            label.isDefined = true;
+            events.push_back({locCounter, labelId, 0, true});
+        }
+        else
+        {
+            define_symbol(labelId, locCounter);
+        }
+        // Se existia uma definição pendente usada aqui, dá um clear para
+        // não considerar o mesmo rótulo de novo nas próximas linhas
+        if (pendingDefinition == currentLabel)
+        {
+            pendingDefinition.clear();
+        }
+    }
 
-                // Se não, define o rótulo agora (instrução segue na mesma linha)
-                // Caso: ROTULO: ADD N1
-                if (symtab.count(currentLabel) && symtab[currentLabel].isDefined)
-                {
-                    throw runtime_error("Rotulo '" + currentLabel + "' declarado duas vezes.");
-                }
+    const Token &mainToken = tokens[tokenIndex];
+
+    if (mainToken.type == TokenType::INSTRUCTION)
+    {
+        const OpInfo &opInfo = *mainToken.op;
+
+        // Os operandos são os tokens após a instrução; o léxico já separou
+        // LABEL+3 (ou LABEL + 3) em base e offset.
+        size_t firstOperand = tokenIndex + 1;
+        if (tokens.size() - firstOperand != static_cast<size_t>(opInfo.numParameters)) {
+            report(DiagCode::WRONG_OPERAND_COUNT, lineNumber, mainToken.value);
+            return;
+        }
 
-                // Adiciona ou atualiza o rótulo na Tabela de Símbolos (SYMTAB)
-                symtab[currentLabel].address = locCounter;
-                symtab[currentLabel].isDefined = true;
-
-                // Resolve as pendências do rótulo na sua declaração
-                if (symtab[currentLabel].pendingListHead != -1) {
-                    int cur = symtab[currentLabel].pendingListHead;
-                    while (cur != -1) {
-                        if (cur < 0 || static_cast<size_t>(cur) >= codigoObjeto.size()) {
-                            throw runtime_error("Lista de pendencias corrompida ao resolver rotulo: " + currentLabel);
-                        }
-                        int nextLoc = codigoObjeto[cur];
-                        int offset = 0;
-                        auto itOff = pendingOffsets.find(cur);
-                        if (itOff != pendingOffsets.end()) {
-                            offset = itOff->second;
-                            pendingOffsets.erase(itOff);
-                        }
-                        // escreve o endereço final (endereço do símbolo + offset)
-                        codigoObjeto[cur] = symtab[currentLabel].address + offset;
-                        cur = nextLoc;
-                    }
-                    // limpa a cabeça da lista de pendências
-                    symtab[currentLabel].pendingListHead = -1;
+        // grava opcode
+        if (optimizing)
+            codeItems.push_back({static_cast<int>(codigoObjeto.size()), opInfo.opcode, opInfo.size});
+        codigoObjeto.push_back(opInfo.opcode);
+
+        for (size_t pi = firstOperand; pi < tokens.size(); ++pi) {
+            const Token &operand = tokens[pi];
+
+            // Expressão LABEL+offset
+            int offset = 0;
+            bool hasOffset = !operand.offset.empty();
+            if (hasOffset) {
+                if (!is_number(operand.offset)) {
+                    report(DiagCode::INVALID_OPERAND, lineNumber, operand.value);
+                    return;
                 }
-                // Se existia uma definição pendente usada aqui, dá um clear para
-                // não considerar o mesmo rótulo de novo nas próximas linhas
-                if (pendingDefinition == currentLabel)
-                {
-                    pendingDefinition.clear();
+                if (!parse_number(operand.offset, offset)) {
+                    report(DiagCode::NUMBER_OUT_OF_RANGE, lineNumber, operand.offset);
+                    return;
                 }
             }
 
-            Token mainToken = tokens[tokenIndex];
-
-            if (mainToken.type == TokenType::INSTRUCTION)
-            {
-                const OpInfo &opInfo = optab.at(mainToken.value);
-
-                // Parse dos operandos para: LABEL+3 or LABEL + 3
-                std::vector<std::string> operands;
-                size_t i = tokenIndex + 1;
-                while (i < tokens.size()) {
-                    std::string op = tokens[i].value;
-                    i += 1;
-                    operands.push_back(op);
+            // Suporte pra imediatos (apesar de não serem permitidos na especificação)
+            if (!hasOffset && is_number(operand.base)) {
+                int imm;
+                if (!parse_number(operand.base, imm)) {
+                    report(DiagCode::NUMBER_OUT_OF_RANGE, lineNumber, operand.base);
+                    return;
                 }
+                hasImmediate = true;
+                codigoObjeto.push_back(imm);
+                continue;
+            }
 
-                if (operands.size() != static_cast<size_t>(opInfo.numParameters)) {
-                    throw runtime_error("Instrução '" + mainToken.value + "' com número de parâmetros errado.");
-                }
+            // Interna o símbolo uma única vez (cria a entrada na SYMTAB se não existir)
+            int symbolId = symtab.intern(operand.base);
+            int loc = static_cast<int>(codigoObjeto.size());
+            codigoObjeto.push_back(0);
+            if (deferred) {
+                // A resolução fica para a junção dos blocos.
+                events.push_back({loc, symbolId, offset, false});
+            } else {
+                reference_symbol(symbolId, offset, loc);
+            }
+        }
 
-                // grava opcode em ambas as representações (O1 mantém pendências)
-                codigoObjeto.push_back(opInfo.opcode);
-                codigoObjetoO1.push_back(opInfo.opcode);
-
-                for (size_t pi = 0; pi < operands.size(); ++pi) {
-                    std::string param = operands[pi];
-
-                    // Detecta expressão LABEL+offset
-                    size_t plusPos = param.find('+');
-                    std::string base = param;
-                    int offset = 0;
-                    if (plusPos != std::string::npos) {
-                        base = param.substr(0, plusPos);
-                        std::string offStr = param.substr(plusPos + 1);
-                        if (offStr.empty() || !all_of(offStr.begin(), offStr.end(), ::isdigit)) {
-                            throw runtime_error("Operando inválido: " + param);
-                        }
-                        offset = stoi(offStr);
-                    }
-
-                    // Suporte pra imediatos (apesar de não serem permitidos na especificação)
-                    if (plusPos == std::string::npos && !base.empty() && all_of(base.begin(), base.end(), ::isdigit)) {
-                        int imm = stoi(base);
-                        codigoObjeto.push_back(imm);
-                        codigoObjetoO1.push_back(imm);
-                        continue;
-                    }
-
-                    if (symtab.count(base) && symtab[base].isDefined) {
-                        int resolvedVal = symtab[base].address + offset;
-                        codigoObjeto.push_back(resolvedVal);
-                        codigoObjetoO1.push_back(resolvedVal);
-                    } else {
-                        int previousHead = -1;
-                        if (symtab.count(base)){
-                            previousHead = symtab[base].pendingListHead;
-                        } else {
-                            // Inicializa entrada na SYMTAB se não existir
-                            symtab[base];
-                        }
-
-                        // posição atual do código
-                        int loc = static_cast<int>(codigoObjeto.size());
-
-                        // placeholder no código objeto (guarda o head anterior como 'next')
-                        codigoObjeto.push_back(previousHead);
-                        // grava a mesma placeholder no O1 para n resolver pendencia
-                        codigoObjetoO1.push_back(previousHead);
-
-                        // armazena offset e link para a lista ligada em maps separados
-                        pendingOffsets[loc] = offset;
-
-                        symtab[base].pendingListHead = loc;
-                    }
-                }
+        locCounter += opInfo.size;
+    }
+    else if (mainToken.type == TokenType::DIRECTIVE)
+    {
+        if (mainToken.value == "CONST")
+        {
+            if (tokens.size() <= tokenIndex + 1)
+            {
+                report(DiagCode::CONST_OPERAND_COUNT, lineNumber);
+                return;
+            }
+            string_view param = tokens[tokenIndex + 1].value;
 
-                locCounter += opInfo.size;
+            if (!is_number(param))
+            {
+                report(DiagCode::CONST_NOT_NUMBER, lineNumber);
+                return;
             }
-            else if (mainToken.type == TokenType::DIRECTIVE)
+            int constVal;
+            if (!parse_number(param, constVal))
             {
-                if (mainToken.value == "CONST")
+                report(DiagCode::NUMBER_OUT_OF_RANGE, lineNumber, param);
+                return;
+            }
+            if (optimizing)
+                codeItems.push_back({static_cast<int>(codigoObjeto.size()), 0, 1});
+            codigoObjeto.push_back(constVal);
+            locCounter += 1;
+        }
+        else if (mainToken.value == "SPACE")
+        {
+            int numSpaces = 1; // Default
+            if (tokens.size() - tokenIndex == 2)
+            {
+                string_view param = tokens[tokenIndex + 1].value;
+
+                if (!is_number(param))
                 {
-                    if (tokens.size() <= tokenIndex + 1)
-                    {
-                        throw runtime_error("Diretiva CONST com número de parâmetros errado.");
-                    }
-                    string param = tokens[tokenIndex + 1].value;
-
-                    if (!all_of(param.begin(), param.end(), ::isdigit))
-                    {
-                        throw runtime_error("Valor de CONST não é um número válido.");
-                    }
-                    int constVal = stoi(param);
-                    codigoObjeto.push_back(constVal);
-                    codigoObjetoO1.push_back(constVal);
-                    locCounter += 1;
+                    report(DiagCode::SPACE_NOT_NUMBER, lineNumber);
+                    return;
                 }
-                else if (mainToken.value == "SPACE")
+                if (!parse_number(param, numSpaces))
                 {
-                    int numSpaces = 1; // Default
-                    if (tokens.size() - tokenIndex == 2)
-                    {
-                        string param = tokens[tokenIndex + 1].value;
-
-                        if (!all_of(param.begin(), param.end(), ::isdigit))
-                        {
-                            throw runtime_error("Valor de SPACE não é um número válido.");
-                        }
-                        numSpaces = stoi(param);
-
-                        if (numSpaces <= 0)
-                        {
-                            throw runtime_error("Valor de SPACE deve ser positivo.");
-                        }
-                    }
-                    else if (tokens.size() - tokenIndex > 2)
-                    {
-                        throw runtime_error("Diretiva SPACE com numero de parametros errado.");
-                    }
-                    for (int i = 0; i < numSpaces; i++)
-                    {
-                        codigoObjeto.push_back(0); // Inicializa espaços com zero
-                        codigoObjetoO1.push_back(0);
-                    }
-                    locCounter += numSpaces;
+                    report(DiagCode::NUMBER_OUT_OF_RANGE, lineNumber, param);
+                    return;
                 }
-                else
+
+                if (numSpaces <= 0)
                 {
-                    throw runtime_error("Diretiva desconhecida: " + mainToken.value);
+                    report(DiagCode::SPACE_NOT_POSITIVE, lineNumber);
+                    return;
                 }
-                pendingDefinition = ""; // Diretivas não podem deixar rótulo pendente
             }
-            else
+            else if (tokens.size() - tokenIndex > 2)
             {
-                throw runtime_error("Instrução não reconhecida: " + mainToken.value);
+                report(DiagCode::SPACE_OPERAND_COUNT, lineNumber);
+                return;
             }
+            if (optimizing)
+                codeItems.push_back({static_cast<int>(codigoObjeto.size()), 0, numSpaces});
+            for (int i = 0; i < numSpaces; i++)
+            {
+                codigoObjeto.push_back(0); // Inicializa espaços com zero
+            }
+            locCounter += numSpaces;
         }
-        catch (const LexicalException &le)
+        else if (mainToken.value == "PUBLIC" || mainToken.value == "EXTERN")
         {
-            int errLine = le.getLineNumber() > 0 ? le.getLineNumber() : lineNumber;
-            errors.push_back({errLine, string("Léxico: ") + le.what()});
+            const Token *operand = tokens.size() - tokenIndex == 2 ? &tokens[tokenIndex + 1] : nullptr;
+            if (!module_directive(mainToken, operand))
+                return;
         }
-        catch (const runtime_error &e)
+        else
         {
-            errors.push_back({lineNumber, e.what()});
+            report(DiagCode::UNKNOWN_DIRECTIVE, lineNumber, mainToken.value);
+            return;
         }
+        pendingDefinition = ""; // Diretivas não podem deixar rótulo pendente
+    }
+    else
+    {
+        report(DiagCode::UNKNOWN_INSTRUCTION, lineNumber, mainToken.value);
+        return;
     }
+}
+
+// O rótulo já foi definido (no modo em blocos, também pelos blocos anteriores).
+bool Assembler::is_defined(string_view name) const
+{
+    int id = symtab.find(name);
+    if (id >= 0 && symtab[id].isDefined)
+        return true;
+    int previousId = predefined ? predefined->find(name) : -1;
+    return previousId >= 0 && (*predefined)[previousId].isDefined;
+}
+
+// PUBLIC X marca X para a tabela de definições; EXTERN X declara que X vem de
+// outro módulo: as referências a ele ficam na tabela de uso para o ligador.
+// Retorna false se registrou um erro.
+bool Assembler::module_directive(const Token &directive, const Token *operand)
+{
+    if (!operand)
+    {
+        report(DiagCode::MODULE_OPERAND_COUNT, lineNumber, directive.value);
+        return false;
+    }
+    if (operand->type != TokenType::PARAMETER || !operand->offset.empty())
+    {
+        report(DiagCode::INVALID_OPERAND, lineNumber, operand->value);
+        return false;
+    }
+    if (directive.value == "PUBLIC")
+    {
+        symtab[symtab.intern(operand->base)].isPublic = true;
+        return true;
+    }
+    if (is_defined(operand->base))
+    {
+        report(DiagCode::EXTERN_DEFINED, lineNumber, operand->base);
+        return false;
+    }
+    symtab[symtab.intern(operand->base)].isExtern = true;
+    return true;
+}
+
+// Define o símbolo no endereço dado. As pendências dele ficam na tabela de
+// pendências e são resolvidas em lote no fim da passagem.
+void Assembler::define_symbol(int id, int address)
+{
+    SymbolItem &label = symtab[id];
+    label.address = address;
+    label.isDefined = true;
+}
+
+// Preenche a posição `loc` (já reservada no código) com uma referência ao símbolo.
+void Assembler::reference_symbol(int id, int offset, int loc)
+{
+    SymbolItem &symbol = symtab[id];
+    if (optimizing)
+        symbolRefs.push_back({loc, id, offset, !symbol.isDefined});
+    if (symbol.isDefined) {
+        int resolvedVal = symbol.address + offset;
+        codigoObjeto[loc] = resolvedVal;
+        relocations.push_back(loc);
+    } else {
+        // Referência adiante: registra a pendência; o placeholder é escrito na
+        // resolução em lote.
+        fixups.add(loc, id, offset);
+    }
+}
+
+// Resolve todas as pendências em uma varredura pela tabela (em ordem de slot,
+// ou seja, sequencial no codigoObjeto). Ao mesmo tempo recria a lista
+// encadeada do .o1: o placeholder de cada pendência é o slot da pendência
+// anterior do mesmo símbolo (ou -1). Pendências de rótulos definidos são
+// corrigidas no .o2 e o placeholder vai para o log usado pelo .o1; as de
+// rótulos não definidos mantêm o placeholder nos dois arquivos.
+void Assembler::resolve_fixups()
+{
+    for (size_t i = 0; i < fixups.size(); i++)
+    {
+        int loc = fixups.slot[i];
+        SymbolItem &symbol = symtab[fixups.symbol[i]];
+        int previousHead = symbol.pendingListHead;
+        symbol.pendingListHead = loc;
+        if (symbol.isDefined)
+        {
+            backpatches.push_back({loc, previousHead});
+            codigoObjeto[loc] = symbol.address + fixups.offset[i];
+            relocations.push_back(loc);
+        }
+        else
+        {
+            codigoObjeto[loc] = previousHead;
+        }
+    }
+    // Só rótulos não definidos continuam com lista de pendências.
+    for (int id = 0; id < static_cast<int>(symtab.size()); id++)
+    {
+        if (symtab[id].isDefined)
+            symtab[id].pendingListHead = -1;
+    }
+}
+
+void Assembler::finish_pass()
+{
+    // Só a verificação não precisa do código resolvido.
+    if (!checkOnly)
+        resolve_fixups();
+    // Interrompida no limite de erros, o resto do programa não foi lido: os
+    // rótulos "não declarados" podem estar nele.
+    if (aborted)
+        return;
 
     if (!pendingDefinition.empty())
     {
-        errors.push_back({lineNumber, "Rótulo '" + pendingDefinition + "' declarado sem instrução."});
+        report(DiagCode::LABEL_WITHOUT_INSTRUCTION, lineNumber, pendingDefinition);
     }
 
-    for (const auto &pair : symtab)
+    // Percorre os símbolos na ordem em que apareceram no programa. Os EXTERN
+    // ficam para o ligador, a não ser que o módulo também os exporte.
+    for (int id = 0; id < static_cast<int>(symtab.size()); id++)
     {
-        if (!pair.second.isDefined)
+        const SymbolItem &symbol = symtab[id];
+        if (!symbol.isDefined && (!symbol.isExtern || symbol.isPublic))
         {
-            errors.push_back({-1, "Erro Semântico: Rótulo '" + pair.first + "' não declarado."});
+            report(DiagCode::UNDEFINED_SYMBOL, -1, {}, id);
         }
     }
 }
 
-void Assembler::generate_o1_file(const string &o1_filename)
+// Otimizador peephole (Peephole.cpp) sobre o programa já resolvido. Depois
+// dele a tabela de pendências e o log do .o1 são refeitos com as novas posições.
+void Assembler::optimize()
 {
-    ofstream o1_file(o1_filename);
-    if (!o1_file.is_open())
+    optimizationReport = PeepholeReport();
+    bool isModule = false;
+    for (int id = 0; id < static_cast<int>(symtab.size()) && !isModule; id++)
+        isModule = symtab[id].isExtern || symtab[id].isPublic;
+    if (!diagnostics.empty())
     {
-        throw runtime_error("Erro ao abrir o arquivo de saída O1: " + o1_filename);
+        optimizationReport.skipped = "programa com erros";
+    }
+    else if (isModule)
+    {
+        // Outros módulos podem saltar para os rótulos PUBLIC, e os endereços
+        // dos EXTERN só são conhecidos na ligação.
+        optimizationReport.skipped = "modulo com PUBLIC/EXTERN";
+    }
+    else
+    {
+        PeepholeProgram program;
+        program.words = std::move(codigoObjeto);
+        program.items = std::move(codeItems);
+        program.refs = std::move(symbolRefs);
+        program.hasImmediate = hasImmediate;
+        for (int id = 0; id < static_cast<int>(symtab.size()); id++)
+            program.symbolAddress.push_back(symtab[id].address);
+
+        optimizationReport = optimize_peephole(program);
+        codigoObjeto = std::move(program.words);
+        codeItems = std::move(program.items);
+        symbolRefs = std::move(program.refs);
+
+        if (optimizationReport.applied)
+        {
+            for (int id = 0; id < static_cast<int>(symtab.size()); id++)
+                symtab[id].address = program.symbolAddress[id];
+            locCounter = static_cast<int>(codigoObjeto.size());
+            fixups.clear();
+            backpatches.clear();
+            relocations.clear();
+            for (const SymbolRef &ref : symbolRefs)
+            {
+                if (ref.forward)
+                    fixups.add(ref.slot, ref.symbol, ref.offset);
+                else
+                    relocations.push_back(ref.slot);
+            }
+            resolve_fixups();
+        }
+    }
+
+    if (!optimizationReport.skipped.empty())
+    {
+        LOG_INFO(log, "Otimizacao nao aplicada: " << optimizationReport.skipped);
+        return;
+    }
+    LOG_INFO(log, "Otimizacao: " << optimizationReport.removedInstructions << " instrucao(oes) e "
+                                 << optimizationReport.removedWords << " word(s) removidas, "
+                                 << optimizationReport.threadedJumps << " salto(s) encurtado(s).");
+    if (stats)
+    {
+        stats->removedInstructions += optimizationReport.removedInstructions;
+        stats->removedWords += optimizationReport.removedWords;
+        stats->threadedJumps += optimizationReport.threadedJumps;
+        // objectWords foi contado na passagem, antes da otimização.
+        stats->objectWords -= optimizationReport.removedWords;
     }
+}
 
-    printf("Gerando arquivo O1: %s\n", o1_filename.c_str());
-    for (size_t i = 0; i < codigoObjetoO1.size(); i++)
+void Assembler::assemble_parallel(const LineBatch &lines, unsigned jobs, const string &o1_filename, const string &o2_filename)
+{
+    reset();
+    // Blocos pequenos não compensam o custo da junção.
+    const size_t minChunkLines = 2048;
+    size_t chunkCount = max<size_t>(1, min<size_t>(static_cast<size_t>(jobs) * 4, lines.size() / minChunkLines));
+    size_t chunkLines = (lines.size() + chunkCount - 1) / chunkCount;
+
+    auto assemble_chunk = [&](Assembler &chunk, size_t index, const string &incomingPending, const SymbolTable *previous,
+                              size_t errorLimit)
     {
-        o1_file << codigoObjetoO1[i];
-        if (i < codigoObjetoO1.size() - 1)
+        size_t first = min(lines.size(), index * chunkLines);
+        size_t last = min(lines.size(), first + chunkLines);
+        chunk.start_chunk(static_cast<int>(first) + 1, incomingPending, previous);
+        chunk.timing = timing;
+        chunk.optimizing = optimizing;
+        chunk.foldedInput = foldedInput;
+        chunk.maxErrors = errorLimit;
+        double cpuStart = timing ? thread_cpu_seconds() : 0;
+        for (size_t i = first; i < last && !chunk.aborted; i++)
         {
-            o1_file << " ";
+            if (timing)
+                chunk.timed_line(lines.line(i));
+            else
+                chunk.assemble_line(lines.line(i));
         }
+        if (timing)
+            chunk.cpuTime += thread_cpu_seconds() - cpuStart;
+    };
+
+    // Fase 1 (paralela): cada bloco supõe que começa sem rótulo pendente e que
+    // nenhum dos rótulos que ele define já foi definido antes.
+    vector<unique_ptr<Assembler>> chunks(chunkCount);
+    parallel_for(chunkCount, jobs, [&](size_t index)
+                 {
+        chunks[index] = make_unique<Assembler>(log);
+        assemble_chunk(*chunks[index], index, "", nullptr, maxErrors); });
+
+    // Fase 2 (sequencial): soma de prefixo dos endereços e resolução dos
+    // símbolos/pendências na ordem do programa. Se a suposição de um bloco
+    // falhou, ele é remontado com o contexto correto antes da junção. O mesmo
+    // vale para o bloco em que o limite de erros é atingido: remontado com o
+    // limite que resta, ele para na mesma linha que a passagem única.
+    auto mergeStart = chrono::steady_clock::now();
+    double mergeCpuStart = timing ? thread_cpu_seconds() : 0;
+    AllocationCount mergeHeapStart = thread_allocations();
+    for (size_t index = 0; index < chunkCount; index++)
+    {
+        size_t remaining = maxErrors != 0 ? maxErrors - diagnostics.size() : 0;
+        bool reachesLimit = maxErrors != 0 && chunks[index]->diagnostics.size() >= remaining;
+        if (!chunk_matches(*chunks[index]) || reachesLimit)
+        {
+            chunks[index] = make_unique<Assembler>(log);
+            assemble_chunk(*chunks[index], index, pendingDefinition, &symtab, remaining);
+        }
+        merge_chunk(*chunks[index]);
+        chunks[index].reset();
+        if (aborted)
+            break;
+    }
+    finish_pass();
+    if (timing)
+    {
+        // A junção conta como codificação; o tempo dos blocos já veio na soma.
+        lineTime += chrono::steady_clock::now() - mergeStart;
+        cpuTime += thread_cpu_seconds() - mergeCpuStart;
+        lineHeap += thread_allocations() - mergeHeapStart;
+        collect_stats();
+    }
+    if (optimizing && !checkOnly)
+        optimize();
+    write_outputs(o1_filename, o2_filename);
+}
+
+void Assembler::start_chunk(int firstLineNumber, const string &incomingPending, const SymbolTable *previous)
+{
+    deferred = true;
+    lineNumber = firstLineNumber - 1;
+    pendingDefinition = incomingPending;
+    startPending = incomingPending;
+    predefined = previous;
+}
+
+// O bloco foi montado com o contexto certo se recebeu o mesmo rótulo pendente
+// que o bloco anterior deixou e se não redefine rótulos já definidos.
+bool Assembler::chunk_matches(const Assembler &chunk) const
+{
+    if (chunk.startPending != pendingDefinition)
+        return false;
+    if (chunk.predefined)
+        return true;
+    for (const ChunkEvent &event : chunk.events)
+    {
+        if (!event.isDefinition)
+            continue;
+        int id = symtab.find(chunk.symtab.name(event.symbol));
+        if (id >= 0 && (symtab[id].isDefined || symtab[id].isExtern))
+            return false;
+    }
+    // EXTERN de um rótulo que um bloco anterior definiu.
+    for (int localId = 0; localId < static_cast<int>(chunk.symtab.size()); localId++)
+    {
+        if (!chunk.symtab[localId].isExtern)
+            continue;
+        int id = symtab.find(chunk.symtab.name(localId));
+        if (id >= 0 && symtab[id].isDefined)
+            return false;
+    }
+    return true;
+}
+
+// Anexa o código do bloco e repete, na ordem, as definições e referências que
+// a passagem única faria, com endereços deslocados pela posição do bloco.
+void Assembler::merge_chunk(const Assembler &chunk)
+{
+    int codeBase = static_cast<int>(codigoObjeto.size());
+    int locBase = locCounter;
+    codigoObjeto.insert(codigoObjeto.end(), chunk.codigoObjeto.begin(), chunk.codigoObjeto.end());
+
+    // IDs locais estão em ordem de primeira aparição, então internar nessa
+    // ordem mantém a ordem global da passagem única.
+    vector<int> globalIds(chunk.symtab.size());
+    for (size_t id = 0; id < globalIds.size(); id++)
+    {
+        globalIds[id] = symtab.intern(chunk.symtab.name(static_cast<int>(id)));
+        const SymbolItem &local = chunk.symtab[static_cast<int>(id)];
+        symtab[globalIds[id]].isExtern |= local.isExtern;
+        symtab[globalIds[id]].isPublic |= local.isPublic;
+    }
+
+    for (const ChunkEvent &event : chunk.events)
+    {
+        if (event.isDefinition)
+            define_symbol(globalIds[event.symbol], locBase + event.position);
+        else
+            reference_symbol(globalIds[event.symbol], event.offset, codeBase + event.position);
+    }
+
+    // Os detalhes dos erros do bloco vão para o fim do texto deste montador.
+    uint32_t textBase = static_cast<uint32_t>(diagnosticText.size());
+    diagnosticText += chunk.diagnosticText;
+    for (Diagnostic diagnostic : chunk.diagnostics)
+    {
+        diagnostic.detailBegin += textBase;
+        diagnostics.push_back(diagnostic);
     }
+    errorsFormatted = false;
+    aborted = chunk.aborted;
+    for (const CodeItem &item : chunk.codeItems)
+        codeItems.push_back({codeBase + item.start, item.opcode, item.size});
+    hasImmediate = hasImmediate || chunk.hasImmediate;
+    assembledLines += chunk.assembledLines;
+    tokenCount += chunk.tokenCount;
+    longestLine = max(longestLine, chunk.longestLine);
+    lineTime += chunk.lineTime;
+    tokenizeTime += chunk.tokenizeTime;
+    lineHeap += chunk.lineHeap;
+    tokenizeHeap += chunk.tokenizeHeap;
+    cpuTime += chunk.cpuTime;
+    locCounter = locBase + chunk.locCounter;
+    lineNumber = chunk.lineNumber;
+    pendingDefinition = chunk.pendingDefinition;
+}
+
+void Assembler::generate_o1_file(const string &o1_filename)
+{
+    ofstream o1_file(o1_filename, ios::binary);
+    if (!o1_file.is_open())
+    {
+        throw runtime_error("Erro ao abrir o arquivo de saída O1: " + o1_filename);
+    }
+
+    LOG_INFO(log, "Gerando arquivo O1: " << o1_filename);
+    // O .o1 é o código com os placeholders originais nas posições corrigidas
+    // (o log já está em ordem de slot).
+    write_text_object(o1_file, codigoObjeto, backpatches);
     o1_file.close();
 }
 
 void Assembler::generate_o2_file(const string &o2_filename)
 {
-    ofstream o2_file(o2_filename);
+    ofstream o2_file(o2_filename, ios::binary);
     if (!o2_file.is_open())
     {
         throw runtime_error("Erro ao abrir o arquivo de saída O2: " + o2_filename);
     }
 
-    printf("Gerando arquivo O2 (resolvido): %s\n", o2_filename.c_str());
-    for (size_t i = 0; i < codigoObjeto.size(); i++)
-    {
-        o2_file << codigoObjeto[i];
-        if (i < codigoObjeto.size() - 1)
-        {
-            o2_file << " ";
-        }
-    }
+    LOG_INFO(log, "Gerando arquivo O2 (resolvido): " << o2_filename);
+    write_text_object(o2_file, codigoObjeto);
     o2_file.close();
 }
\ No newline at end of file
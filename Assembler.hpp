@@ -5,49 +5,178 @@
 #include <vector>
 #include <unordered_map>
 #include <list>
+#include "Diagnostic.hpp"
+#include "Log.hpp"
 #include "LexicalAnalyzer.hpp"
+#include "LineStream.hpp"
+#include "OpTable.hpp"
+#include "SymbolTable.hpp"
+#include "ObjectFile.hpp"
+#include "FixupTable.hpp"
+#include "Stats.hpp"
+#include "Peephole.hpp"
+#include <chrono>
 
 using namespace std;
 
-struct OpInfo {
-    int opcode;
-    int size;           // Tamanho em words de memória.
-    int numParameters;
-};
-
-// Item da Tabela de Símbolos.
-struct SymbolItem {
-    int address;
-    bool isDefined = false; 
-    int pendingListHead = -1;
+// Evento registrado na montagem em blocos: definição de rótulo ou referência a
+// símbolo, na ordem em que aparecem no bloco. A resolução é feita na junção.
+struct ChunkEvent {
+    int position;       // definição: endereço local; referência: posição local no código
+    int symbol;         // ID do símbolo na tabela local do bloco
+    int offset;         // referência: offset de LABEL+offset
+    bool isDefinition;
 };
 
 class Assembler {
 public:
+    explicit Assembler(Logger& log = Logger::standard()) : log(log) {}
+
     void assemble(const string& input_filename, const string& o1_filename, const string& o2_filename);
+    // Monta consumindo as linhas diretamente do pré-processador, sem .pre intermediário.
+    void assemble(LineSource& input, const string& o1_filename, const string& o2_filename);
+    // Montagem paralela de um programa já pré-processado: as linhas são
+    // divididas em blocos que são tokenizados e codificados em paralelo (com
+    // tabelas de símbolos locais) e depois juntados em sequência. Gera
+    // exatamente os mesmos .o1/.o2 que a montagem de passagem única.
+    void assemble_parallel(const LineBatch& lines, unsigned jobs, const string& o1_filename, const string& o2_filename);
+    // Também grava o objeto em formato binário (.obj) ao gerar as saídas.
+    void set_binary_output(const string& filename) { binary_filename = filename; }
+    // Imagem resolvida (.o2) com as cadeias de pendências que sobraram.
+    ObjectImage object_image() const;
+    // Só a passagem 1 (sem gravar os objetos); usada também pelos benchmarks.
+    // Continua do estado atual: para reaproveitar a instância, chame reset().
+    void pass(LineSource& input);
+    // Passagem empurrada linha a linha (ex: direto do pré-processador, sem
+    // fila): feed() monta uma linha e finish() resolve as pendências e, com
+    // set_optimize, otimiza.
+    void feed(string_view inputLine);
+    void finish();
+    // Volta ao estado inicial mantendo a capacidade alocada (tabela de
+    // símbolos, código, pendências, buffers). As configurações (set_optimize,
+    // set_stats, set_binary_output) são mantidas. assemble() já chama.
+    void reset();
+    // Código resolvido (.o2) da última montagem.
+    const vector<int>& object_code() const { return codigoObjeto; }
+    // Código com os placeholders das pendências (.o1), escrito em `out`.
+    void object_code_o1(vector<int>& out) const;
+    // Aplica o otimizador peephole entre a passagem e a gravação dos objetos.
+    void set_optimize(bool enabled) { optimizing = enabled; }
+    // Resultado da última otimização (vazio se não foi pedida).
+    const PeepholeReport& optimization() const { return optimizationReport; }
+    // Acumula tempos e contadores da montagem em `stats` (--stats).
+    void set_stats(CompileStats* target) { stats = target; timing = target != nullptr; }
+    // Para a passagem ao chegar em `limit` erros (--max-errors); 0: sem limite.
+    // Interrompida, a montagem não grava os objetos.
+    void set_max_errors(size_t limit) { maxErrors = limit; }
+    // Só verifica o programa (--check): não resolve as pendências, não otimiza
+    // e não grava os objetos; os erros são os mesmos da montagem completa.
+    void set_check_only(bool enabled) { checkOnly = enabled; }
+    // As linhas de entrada já estão em maiúsculas (saída do Preprocessor):
+    // a passagem não as copia nem converte.
+    void set_folded_input(bool enabled) { foldedInput = enabled; }
+    // A última montagem parou no limite de set_max_errors.
+    bool stopped_early() const { return aborted; }
+    // Erros da última montagem, na ordem em que foram encontrados.
+    const vector<Diagnostic>& diagnostic_records() const { return diagnostics; }
+    size_t error_count() const { return diagnostics.size(); }
+    // Mensagem de um dos erros (como aparece depois de "Linha N: ").
+    string message(const Diagnostic& diagnostic) const;
+    // Erros (linha, mensagem) encontrados na última montagem. As mensagens são
+    // formatadas na primeira chamada depois da montagem.
+    const vector<pair<int, string>>& getErrors() const;
 
 private:
-    void initialize_optab();
-    void pass(const string& input_filename);
+    Logger& log;
+
+    void assemble_line(string_view inputLine);
+    void report(DiagCode code, int line, string_view detail = {}, int symbol = -1);
+    void report_errors();
+    void define_symbol(int id, int address);
+    bool module_directive(const Token& directive, const Token* operand);
+    bool is_defined(string_view name) const;
+    void reference_symbol(int id, int offset, int loc);
+    void resolve_fixups();
+    void finish_pass();
+    void optimize();
+    void timed_line(string_view inputLine);
+    void collect_stats();
+    void write_outputs(const string& o1_filename, const string& o2_filename);
+
+    // Montagem em blocos
+    void start_chunk(int firstLineNumber, const string& incomingPending, const SymbolTable* previous);
+    bool chunk_matches(const Assembler& chunk) const;
+    void merge_chunk(const Assembler& chunk);
     void generate_o1_file(const string& filename);
     void generate_o2_file(const string& filename);
+    string binary_filename;
     
     LexicalAnalyzer lexicalAnalyzer;
 
-    // Tabela de Operações
-    unordered_map<string, OpInfo> optab;
+    // Estado da passagem (mantido entre linhas)
+    int locCounter = 0;
+    int lineNumber = 0;
+    string pendingDefinition;
+    // Reaproveitados entre linhas para não alocar a cada iteração.
+    string upperLine;
+    vector<Token> tokens;
+    string currentLabel;
+
+    // Modo em blocos: registra eventos em vez de resolver pendências.
+    bool deferred = false;
+    // Símbolos definidos pelos blocos anteriores (para detectar rótulos duplicados).
+    const SymbolTable* predefined = nullptr;
+    // Rótulo pendente recebido do bloco anterior ao montar este bloco.
+    string startPending;
+    vector<ChunkEvent> events;
 
     // Tabela de Símbolos
-    unordered_map<string, SymbolItem> symtab;
+    SymbolTable symtab;
 
     vector<int> codigoObjeto;
-    // (para gerar .o1)
-    vector<int> codigoObjetoO1;
+    // Log das correções feitas no codigoObjeto (posição -> placeholder
+    // original). O .o1 é reconstruído a partir dele na hora de gravar.
+    vector<Backpatch> backpatches;
+
+    // Pendências (referências adiante), resolvidas em lote no fim da passagem.
+    FixupTable fixups;
+    // Posições com endereços de rótulos do programa (relocáveis), fora de
+    // ordem; viram o mapa de relocação do objeto.
+    vector<int> relocations;
+
+    // Erros registrados sem formatar: o texto de detalhe de cada um fica em
+    // diagnosticText (ou é o nome do símbolo). Nenhuma exceção na passagem.
+    vector<Diagnostic> diagnostics;
+    string diagnosticText;
+    mutable vector<pair<int, string>> formattedErrors;
+    mutable bool errorsFormatted = false;
+    size_t maxErrors = 0;
+    bool aborted = false;
+    bool checkOnly = false;
+    bool foldedInput = false;
 
-    // índice no codigoObjeto -> offset pendente
-    std::unordered_map<int,int> pendingOffsets;
+    // Otimização: instruções/dados e referências a símbolos registrados na
+    // passagem (só com `optimizing`).
+    bool optimizing = false;
+    vector<CodeItem> codeItems;
+    vector<SymbolRef> symbolRefs;
+    bool hasImmediate = false;
+    PeepholeReport optimizationReport;
 
-    vector<pair<int, string>> errors;
+    // Instrumentação (--stats). Os blocos do modo paralelo medem com os seus
+    // próprios contadores, somados na junção.
+    CompileStats* stats = nullptr;
+    bool timing = false;
+    size_t assembledLines = 0;
+    size_t tokenCount = 0;
+    size_t longestLine = 0;
+    chrono::steady_clock::duration lineTime{};
+    chrono::steady_clock::duration tokenizeTime{};
+    double cpuTime = 0;
+    // Alocações no heap da thread durante as linhas (e a junção/resolução) e
+    // só dentro do scanner.
+    AllocationCount lineHeap;
+    AllocationCount tokenizeHeap;
 };
 
 #endif // ASSEMBLER_HPP
\ No newline at end of file
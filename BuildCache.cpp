@@ -0,0 +1,267 @@
+#include "BuildCache.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <unistd.h>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace
+{
+    // Cabeçalho do arquivo de entrada; mudar o formato exige mudar a versão.
+    constexpr string_view ENTRY_MAGIC = "ASMCACHE 1\n";
+    constexpr string_view ENTRY_SUFFIX = ".entry";
+
+    uint64_t rotl(uint64_t x, int r)
+    {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    // Finalizador do splitmix64: espalha todos os bits da palavra.
+    uint64_t avalanche(uint64_t x)
+    {
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+
+    void append_hex(string &out, uint64_t value)
+    {
+        static const char digits[] = "0123456789abcdef";
+        for (int shift = 60; shift >= 0; shift -= 4)
+            out.push_back(digits[(value >> shift) & 0xF]);
+    }
+
+    // Registro "<tag> <a> <tamanho>\n<bytes>" do arquivo de entrada.
+    void put_record(string &out, char tag, const string &name, const string &data)
+    {
+        out.push_back(tag);
+        out += ' ';
+        out += name;
+        out += ' ';
+        out += to_string(data.size());
+        out += '\n';
+        out += data;
+    }
+
+    // Lê um registro em `pos`; falso se o arquivo estiver truncado ou malformado.
+    bool get_record(string_view text, size_t &pos, char &tag, string &name, string &data)
+    {
+        size_t eol = text.find('\n', pos);
+        if (eol == string_view::npos || eol - pos < 2 || text[pos + 1] != ' ')
+            return false;
+        tag = text[pos];
+        string_view header = text.substr(pos + 2, eol - pos - 2);
+        size_t space = header.rfind(' ');
+        if (space == string_view::npos)
+            return false;
+        size_t size = 0;
+        string_view digits = header.substr(space + 1);
+        auto parsed = from_chars(digits.data(), digits.data() + digits.size(), size);
+        if (parsed.ec != errc() || parsed.ptr != digits.data() + digits.size() || size > text.size() - eol - 1)
+            return false;
+        name.assign(header.substr(0, space));
+        data.assign(text.substr(eol + 1, size));
+        pos = eol + 1 + size;
+        return true;
+    }
+
+    bool read_file(const string &path, string &contents)
+    {
+        ifstream file(path, ios::binary);
+        if (!file)
+            return false;
+        ostringstream buffer;
+        buffer << file.rdbuf();
+        contents = buffer.str();
+        return !file.bad();
+    }
+}
+
+string read_file_contents(const string &path)
+{
+    string contents;
+    if (!read_file(path, contents))
+        throw runtime_error("Nao foi possivel ler o arquivo: " + path);
+    return contents;
+}
+
+string content_hash(string_view data)
+{
+    // Duas pistas de 64 bits com constantes diferentes, 8 bytes por passo.
+    uint64_t a = 0x9E3779B97F4A7C15ull ^ data.size();
+    uint64_t b = 0xC2B2AE3D27D4EB4Full ^ rotl(data.size(), 32);
+    size_t i = 0;
+    for (; i + 8 <= data.size(); i += 8)
+    {
+        uint64_t word;
+        memcpy(&word, data.data() + i, 8);
+        a = rotl((a ^ word) * 0x9FB21C651E98DF25ull, 29);
+        b = rotl((b ^ word) * 0xFF51AFD7ED558CCDull, 31);
+    }
+    uint64_t tail = 0;
+    if (i < data.size())
+        memcpy(&tail, data.data() + i, data.size() - i);
+    a = avalanche(a ^ tail);
+    b = avalanche(b ^ rotl(tail, 17) ^ a);
+
+    string hex;
+    hex.reserve(32);
+    append_hex(hex, a);
+    append_hex(hex, b);
+    return hex;
+}
+
+BuildCache::BuildCache(string directory, uintmax_t maxBytes) : dir(std::move(directory)), maxBytes(maxBytes)
+{
+    error_code ec;
+    fs::create_directories(dir, ec);
+    if (!fs::is_directory(dir, ec))
+    {
+        throw runtime_error("Nao foi possivel criar o diretorio de cache: " + dir);
+    }
+}
+
+string BuildCache::default_directory()
+{
+    if (const char *env = getenv("ASM_CACHE_DIR"); env && *env)
+        return env;
+    if (const char *xdg = getenv("XDG_CACHE_HOME"); xdg && *xdg)
+        return string(xdg) + "/asm-compiler";
+    if (const char *home = getenv("HOME"); home && *home)
+        return string(home) + "/.cache/asm-compiler";
+    return ".asm-cache";
+}
+
+string BuildCache::key(string_view source, const string &config) const
+{
+    return content_hash(source) + content_hash(config).substr(0, 16);
+}
+
+bool BuildCache::load(const string &key, CacheEntry &entry) const
+{
+    string path = dir + "/" + key + string(ENTRY_SUFFIX);
+    string text;
+    if (!read_file(path, text))
+        return false;
+
+    CacheEntry loaded;
+    bool complete = false;
+    size_t pos = ENTRY_MAGIC.size();
+    if (text.compare(0, ENTRY_MAGIC.size(), ENTRY_MAGIC) == 0)
+    {
+        char tag;
+        string name, data;
+        while (get_record(text, pos, tag, name, data))
+        {
+            if (tag == 'E')
+            {
+                loaded.errors.push_back({atoi(name.c_str()), std::move(data)});
+            }
+            else if (tag == 'F')
+            {
+                loaded.files.push_back({std::move(name), std::move(data)});
+            }
+            else if (tag == 'Z' && pos == text.size())
+            {
+                complete = true;
+                break;
+            }
+            else
+            {
+                break;
+            }
+        }
+    }
+
+    error_code ec;
+    if (!complete)
+    {
+        fs::remove(path, ec);
+        return false;
+    }
+    // Marca a entrada como usada agora para o evict() (LRU pela data).
+    fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+    entry = std::move(loaded);
+    return true;
+}
+
+void BuildCache::store(const string &key, const CacheEntry &entry)
+{
+    string text(ENTRY_MAGIC);
+    for (const auto &error : entry.errors)
+        put_record(text, 'E', to_string(error.first), error.second);
+    for (const auto &file : entry.files)
+        put_record(text, 'F', file.first, file.second);
+    put_record(text, 'Z', "fim", "");
+
+    // Grava num temporário único e renomeia: quem lê nunca vê uma entrada pela metade.
+    string path = dir + "/" + key + string(ENTRY_SUFFIX);
+    string temp = path + ".tmp." + to_string(getpid()) + "." + to_string(tempCounter.fetch_add(1));
+    {
+        ofstream out(temp, ios::binary | ios::trunc);
+        out.write(text.data(), static_cast<streamsize>(text.size()));
+        if (!out)
+        {
+            out.close();
+            error_code ec;
+            fs::remove(temp, ec);
+            throw runtime_error("Nao foi possivel gravar no cache: " + temp);
+        }
+    }
+    error_code ec;
+    fs::rename(temp, path, ec);
+    if (ec)
+    {
+        fs::remove(temp, ec);
+        throw runtime_error("Nao foi possivel gravar no cache: " + path);
+    }
+    storedBytes += text.size();
+}
+
+void BuildCache::evict()
+{
+    if (storedBytes.exchange(0) == 0)
+        return;
+
+    struct Item
+    {
+        fs::file_time_type time;
+        uintmax_t size;
+        fs::path path;
+    };
+    vector<Item> items;
+    uintmax_t total = 0;
+    error_code ec;
+    for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec))
+    {
+        const fs::path &path = it->path();
+        if (path.extension() != ENTRY_SUFFIX)
+            continue;
+        error_code itemEc;
+        uintmax_t size = it->file_size(itemEc);
+        fs::file_time_type time = it->last_write_time(itemEc);
+        if (itemEc)
+            continue; // apagada por outro processo no meio da varredura
+        items.push_back({time, size, path});
+        total += size;
+    }
+    if (total <= maxBytes)
+        return;
+
+    sort(items.begin(), items.end(), [](const Item &x, const Item &y)
+         { return x.time < y.time; });
+    for (const Item &item : items)
+    {
+        if (total <= maxBytes)
+            break;
+        fs::remove(item.path, ec);
+        total -= item.size;
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef BUILD_CACHE_HPP
+#define BUILD_CACHE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Resultado de uma compilação guardado no cache: a lista de erros do montador
+// e o conteúdo de cada artefato, indexado pela extensão (".pre", ".o1"...).
+struct CacheEntry {
+    vector<pair<int, string>> errors;
+    vector<pair<string, string>> files;
+};
+
+// Cache em disco de compilações, endereçado pelo conteúdo: a chave é um hash
+// dos bytes da entrada mais a versão do montador e as opções que mudam a
+// saída. Cada entrada é um único arquivo `<chave>.entry` no diretório do
+// cache, gravado num temporário e renomeado, então várias threads ou
+// processos podem usar o mesmo diretório. O tamanho é limitado por evict(),
+// que apaga as entradas usadas há mais tempo (um acerto atualiza a data de
+// modificação da entrada).
+class BuildCache {
+public:
+    BuildCache(string directory, uintmax_t maxBytes);
+
+    // Chave da compilação do fonte `source` com a configuração `config`
+    // (versão + opções). O chamador monta exatamente esses bytes, para que a
+    // chave corresponda aos artefatos mesmo se o arquivo mudar no meio.
+    string key(string_view source, const string& config) const;
+    // Procura a entrada; uma entrada corrompida é apagada e conta como falta.
+    bool load(const string& key, CacheEntry& entry) const;
+    // Grava a entrada. Lança runtime_error em falha de E/S.
+    void store(const string& key, const CacheEntry& entry);
+    // Apaga as entradas mais antigas até o diretório caber em maxBytes. Só
+    // varre o diretório se algo foi gravado desde a última chamada.
+    void evict();
+
+    const string& directory() const { return dir; }
+
+    // $ASM_CACHE_DIR, $XDG_CACHE_HOME/asm-compiler, ~/.cache/asm-compiler ou
+    // .asm-cache, nessa ordem.
+    static string default_directory();
+
+private:
+    string dir;
+    uintmax_t maxBytes;
+    atomic<uintmax_t> storedBytes{0};
+    atomic<unsigned> tempCounter{0};
+};
+
+// Conteúdo inteiro de um arquivo. Lança runtime_error se não puder ser lido.
+string read_file_contents(const string& path);
+
+// Hash de 128 bits (em hexadecimal) de `data`; rápido, não criptográfico.
+string content_hash(string_view data);
+
+#endif // BUILD_CACHE_HPP
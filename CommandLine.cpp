@@ -0,0 +1,207 @@
+#include "CommandLine.hpp"
+#include "Driver.hpp"
+#include <algorithm>
+#include <memory>
+#include <thread>
+
+using namespace std;
+
+namespace {
+
+void print_usage(ostream& err, const string& program) {
+    err << "Uso: " << program << " [--no-pre] [--sequential] [--split] [--binary] [-O] [-j N]"
+        << " [--no-cache] [--cache-dir DIR] [--cache-size MB]"
+        << " [--max-macro-depth N] [--max-macro-lines N] [--max-errors N] [--check]"
+        << " [--log-level off|error|info|trace] [--trace-file ARQ] [--stats[=json]] arquivo.asm|diretorio...\n"
+        << "     " << program << " --serve [SOCKET] [-j N]" << endl;
+}
+
+// Imprime o --stats em `err`, para não se misturar às mensagens. No modo lote
+// o JSON é um array com um objeto por arquivo.
+void print_stats(ostream& err, const vector<CompileResult>& results, bool json, bool batch) {
+    if (json) {
+        if (batch) err << "[";
+        for (size_t i = 0; i < results.size(); i++) {
+            if (i > 0) err << ",\n";
+            results[i].stats.print_json(err, results[i].input, results[i].fatal);
+        }
+        err << (batch ? "]\n" : "\n");
+        return;
+    }
+    for (const CompileResult& result : results) {
+        err << "==> Estatisticas: " << result.input << "\n";
+        result.stats.print(err);
+    }
+}
+
+} // namespace
+
+int run_command_line(const string& program, const vector<string>& args, ostream& out, ostream& err) {
+    CompileOptions options;
+    vector<string> paths;
+    unsigned jobs = thread::hardware_concurrency();
+    bool split = false;
+    unique_ptr<TraceFile> traceFile;
+    bool statsJson = false;
+    bool useCache = true;
+    string cacheDir = BuildCache::default_directory();
+    uintmax_t cacheSizeMb = 256;
+
+    // Valida os argumentos da linha de comando.
+    size_t argc = args.size();
+    for (size_t i = 0; i < argc; i++) {
+        const string& arg = args[i];
+        if (arg == "--no-pre") {
+            // Não grava o .pre (saída opcional).
+            options.writePre = false;
+        } else if (arg == "--sequential") {
+            // Pré-processa e monta na mesma thread.
+            options.threaded = false;
+        } else if (arg == "--binary") {
+            // Também gera o objeto binário .obj.
+            options.writeBinary = true;
+        } else if (arg == "--split") {
+            // Monta um único arquivo grande em blocos paralelos (usa -j threads).
+            split = true;
+        } else if (arg == "--max-macro-depth" || arg == "--max-macro-lines") {
+            // Limites da expansão de macros (aninhamento e linhas geradas).
+            try {
+                size_t value = stoul(i + 1 < argc ? args[++i] : string());
+                (arg == "--max-macro-depth" ? options.macroLimits.maxDepth : options.macroLimits.maxExpandedLines) = value;
+            } catch (const exception&) {
+                print_usage(err, program);
+                return 1;
+            }
+        } else if (arg == "--max-errors") {
+            // Para a montagem de cada arquivo no N-ésimo erro (0: sem limite).
+            try {
+                options.maxErrors = stoul(i + 1 < argc ? args[++i] : string());
+            } catch (const exception&) {
+                print_usage(err, program);
+                return 1;
+            }
+        } else if (arg == "--check") {
+            // Só verifica os erros, sem gerar .pre/.o1/.o2/.obj.
+            options.checkOnly = true;
+        } else if (arg == "-O" || arg == "--optimize") {
+            // Otimizador peephole entre a montagem e a gravação dos objetos.
+            options.optimize = true;
+        } else if (arg == "--no-cache") {
+            // Sempre pré-processa e monta, sem consultar nem gravar o cache.
+            useCache = false;
+        } else if (arg == "--cache-dir") {
+            // Diretório do cache de compilação (padrão: ~/.cache/asm-compiler).
+            if (i + 1 >= argc) {
+                print_usage(err, program);
+                return 1;
+            }
+            cacheDir = args[++i];
+        } else if (arg == "--cache-size") {
+            // Tamanho máximo do cache em MB; as entradas mais antigas são apagadas.
+            try {
+                cacheSizeMb = stoull(i + 1 < argc ? args[++i] : string());
+            } catch (const exception&) {
+                print_usage(err, program);
+                return 1;
+            }
+        } else if (arg == "--stats" || arg == "--stats=json") {
+            // Relatório de tempos por fase e contadores, em stderr.
+            options.collectStats = true;
+            statsJson = arg == "--stats=json";
+        } else if (arg == "--log-level") {
+            // Nível das mensagens: off, error, info (padrão) ou trace.
+            if (i + 1 >= argc || !parse_log_level(args[++i], options.logLevel)) {
+                print_usage(err, program);
+                return 1;
+            }
+        } else if (arg == "--trace-file") {
+            // Grava as mensagens de trace neste arquivo em vez do terminal.
+            if (i + 1 >= argc) {
+                print_usage(err, program);
+                return 1;
+            }
+            try {
+                traceFile = make_unique<TraceFile>(args[++i]);
+            } catch (const exception& e) {
+                err << e.what() << endl;
+                return 1;
+            }
+            options.traceFile = traceFile.get();
+        } else if (arg.rfind("-j", 0) == 0) {
+            string value = arg.size() > 2 ? arg.substr(2) : (i + 1 < argc ? args[++i] : string());
+            try {
+                jobs = static_cast<unsigned>(stoul(value));
+            } catch (const exception&) {
+                print_usage(err, program);
+                return 1;
+            }
+        } else if (!arg.empty() && arg[0] == '-') {
+            print_usage(err, program);
+            return 1;
+        } else {
+            paths.push_back(arg);
+        }
+    }
+    if (paths.empty()) {
+        out << "Nenhum arquivo informado. Usando example.asm para debug." << endl;
+        paths.push_back("example.asm");
+    }
+
+    // Sem conseguir criar o diretório, compila normalmente sem cache.
+    unique_ptr<BuildCache> cache;
+    if (useCache) {
+        try {
+            cache = make_unique<BuildCache>(cacheDir, cacheSizeMb * 1024 * 1024);
+            options.cache = cache.get();
+        } catch (const exception& e) {
+            err << e.what() << endl;
+        }
+    }
+
+    vector<string> inputs = collect_inputs(paths);
+    bool batch = inputs.size() != 1 || paths.size() != 1 || inputs[0] != paths[0];
+
+    if (!batch) {
+        // Um único arquivo: mensagens direto no terminal, como antes.
+        if (split) {
+            options.splitJobs = max(2u, jobs);
+        }
+        CompileResult result = compile_file(inputs[0], options, out);
+        if (cache) {
+            cache->evict();
+        }
+        if (options.collectStats) {
+            print_stats(err, {result}, statsJson, false);
+        }
+        // Na verificação, erros de montagem também falham (para uso em scripts).
+        return result.fatal || (options.checkOnly && result.errorCount > 0) ? 1 : 0;
+    }
+
+    // Modo lote: cada arquivo é montado por uma thread do pool. Dentro de um
+    // arquivo os estágios rodam em sequência para não disputar os núcleos.
+    options.threaded = false;
+    vector<CompileResult> results = compile_batch(inputs, options, jobs, out);
+    if (cache) {
+        cache->evict();
+    }
+
+    size_t failures = 0;
+    for (const CompileResult& result : results) {
+        if (!result.ok()) {
+            failures++;
+        }
+    }
+    out << "\nResumo: " << results.size() - failures << " de " << results.size()
+        << " arquivo(s) montado(s) sem erros." << endl;
+    for (const CompileResult& result : results) {
+        if (result.fatal) {
+            out << "  FALHOU: " << result.input << " (erro fatal)" << endl;
+        } else if (result.errorCount > 0) {
+            out << "  FALHOU: " << result.input << " (" << result.errorCount << " erro(s))" << endl;
+        }
+    }
+    if (options.collectStats) {
+        print_stats(err, results, statsJson, true);
+    }
+    return failures == 0 ? 0 : 1;
+}
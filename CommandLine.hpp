@@ -0,0 +1,15 @@
+#ifndef COMMAND_LINE_HPP
+#define COMMAND_LINE_HPP
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Executa o compilador com os argumentos `args` (sem o nome do programa), como
+// o executável `compiler`: mensagens em `out`, uso/--stats em `err`. Os
+// caminhos relativos partem do diretório atual. Retorna o código de saída.
+int run_command_line(const string& program, const vector<string>& args, ostream& out, ostream& err);
+
+#endif // COMMAND_LINE_HPP
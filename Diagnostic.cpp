@@ -0,0 +1,70 @@
+#include "Diagnostic.hpp"
+#include <cctype>
+
+using namespace std;
+
+namespace
+{
+    // Reproduz o token como "N2+3", sem os espaços ao redor do '+'.
+    string compact(string_view word)
+    {
+        string out;
+        for (char c : word)
+        {
+            if (!isspace(static_cast<unsigned char>(c)))
+                out.push_back(c);
+        }
+        return out;
+    }
+}
+
+string lexical_message(DiagCode code, string_view detail)
+{
+    if (code == DiagCode::INVALID_LABEL)
+        return "Rótulo inválido: " + compact(detail);
+    return "Parametero ou rótulo inválido: " + compact(detail);
+}
+
+string diagnostic_message(DiagCode code, string_view detail)
+{
+    string text(detail);
+    switch (code)
+    {
+    case DiagCode::INVALID_LABEL:
+    case DiagCode::INVALID_OPERAND_TOKEN:
+        return "Léxico: " + lexical_message(code, detail);
+    case DiagCode::TWO_LABELS:
+        return "Dois rotulos na mesma linha.";
+    case DiagCode::DUPLICATE_LABEL:
+        return "Rotulo '" + text + "' declarado duas vezes.";
+    case DiagCode::WRONG_OPERAND_COUNT:
+        return "Instrução '" + text + "' com número de parâmetros errado.";
+    case DiagCode::INVALID_OPERAND:
+        return "Operando inválido: " + text;
+    case DiagCode::NUMBER_OUT_OF_RANGE:
+        return "Numero fora do intervalo: " + text;
+    case DiagCode::CONST_OPERAND_COUNT:
+        return "Diretiva CONST com número de parâmetros errado.";
+    case DiagCode::CONST_NOT_NUMBER:
+        return "Valor de CONST não é um número válido.";
+    case DiagCode::SPACE_NOT_NUMBER:
+        return "Valor de SPACE não é um número válido.";
+    case DiagCode::SPACE_NOT_POSITIVE:
+        return "Valor de SPACE deve ser positivo.";
+    case DiagCode::SPACE_OPERAND_COUNT:
+        return "Diretiva SPACE com numero de parametros errado.";
+    case DiagCode::UNKNOWN_DIRECTIVE:
+        return "Diretiva desconhecida: " + text;
+    case DiagCode::MODULE_OPERAND_COUNT:
+        return "Diretiva " + text + " exige um rotulo.";
+    case DiagCode::EXTERN_DEFINED:
+        return "Rotulo '" + text + "' declarado EXTERN e definido no modulo.";
+    case DiagCode::UNKNOWN_INSTRUCTION:
+        return "Instrução não reconhecida: " + text;
+    case DiagCode::LABEL_WITHOUT_INSTRUCTION:
+        return "Rótulo '" + text + "' declarado sem instrução.";
+    case DiagCode::UNDEFINED_SYMBOL:
+        return "Erro Semântico: Rótulo '" + text + "' não declarado.";
+    }
+    return text;
+}
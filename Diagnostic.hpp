@@ -0,0 +1,56 @@
+#ifndef DIAGNOSTIC_HPP
+#define DIAGNOSTIC_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+// Tipo de cada erro de montagem. O texto só é formatado no fim
+// (diagnostic_message), quando as mensagens são impressas.
+enum class DiagCode : uint8_t {
+    // Léxicos (prefixo "Léxico: ")
+    INVALID_LABEL,             // detalhe: o rótulo
+    INVALID_OPERAND_TOKEN,     // detalhe: o token
+    // Sintáticos/semânticos
+    TWO_LABELS,
+    DUPLICATE_LABEL,           // detalhe: o rótulo
+    WRONG_OPERAND_COUNT,       // detalhe: a instrução
+    INVALID_OPERAND,           // detalhe: o operando
+    NUMBER_OUT_OF_RANGE,       // detalhe: o literal
+    CONST_OPERAND_COUNT,
+    CONST_NOT_NUMBER,
+    SPACE_NOT_NUMBER,
+    SPACE_NOT_POSITIVE,
+    SPACE_OPERAND_COUNT,
+    UNKNOWN_DIRECTIVE,         // detalhe: a diretiva
+    MODULE_OPERAND_COUNT,      // detalhe: a diretiva (PUBLIC/EXTERN)
+    EXTERN_DEFINED,            // detalhe: o rótulo
+    UNKNOWN_INSTRUCTION,       // detalhe: o token
+    LABEL_WITHOUT_INSTRUCTION, // detalhe: o rótulo
+    UNDEFINED_SYMBOL,          // detalhe: o símbolo (pelo ID)
+};
+
+// Registro compacto de um erro: o detalhe (rótulo, token...) fica no buffer
+// de texto de quem registrou, ou é o nome do símbolo `symbol` na tabela de
+// símbolos.
+struct Diagnostic {
+    DiagCode code;
+    int line;               // -1: erro do programa inteiro (símbolo não declarado)
+    int symbol;             // ID do símbolo, ou -1
+    uint32_t detailBegin;
+    uint32_t detailLength;
+};
+
+inline bool is_lexical(DiagCode code)
+{
+    return code == DiagCode::INVALID_LABEL || code == DiagCode::INVALID_OPERAND_TOKEN;
+}
+
+// Mensagem de um erro léxico, sem o prefixo (o texto da LexicalException).
+string lexical_message(DiagCode code, string_view detail);
+// Mensagem completa, como aparece depois de "Linha N: ".
+string diagnostic_message(DiagCode code, string_view detail);
+
+#endif // DIAGNOSTIC_HPP
@@ -0,0 +1,356 @@
+#include "Driver.hpp"
+#include "Preprocessor.hpp"
+#include "Assembler.hpp"
+#include "LineStream.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+using namespace std;
+
+string change_extension(const string &filename, const string &new_ext)
+{
+    size_t last_dot = filename.find_last_of(".");
+    if (last_dot == string::npos)
+    {
+        return filename + new_ext;
+    }
+    return filename.substr(0, last_dot) + new_ext;
+}
+
+namespace
+{
+    // Artefatos de uma compilação: extensão e caminho ao lado da entrada.
+    vector<pair<string, string>> artifacts(const string &input_filename, const CompileOptions &options)
+    {
+        vector<pair<string, string>> files;
+        if (options.writePre)
+            files.push_back({".pre", change_extension(input_filename, ".pre")});
+        files.push_back({".o1", change_extension(input_filename, ".o1")});
+        files.push_back({".o2", change_extension(input_filename, ".o2")});
+        if (options.writeBinary)
+            files.push_back({".obj", change_extension(input_filename, ".obj")});
+        return files;
+    }
+
+    // Parte da chave do cache que não vem da entrada: a versão e as opções
+    // que mudam os artefatos (threads e nível de log não mudam).
+    string cache_config(const CompileOptions &options)
+    {
+        ostringstream config;
+        config << ASSEMBLER_VERSION << " pre=" << options.writePre << " bin=" << options.writeBinary
+               << " opt=" << options.optimize << " depth=" << options.macroLimits.maxDepth
+               << " lines=" << options.macroLimits.maxExpandedLines << " max-errors=" << options.maxErrors;
+        return config.str();
+    }
+
+    // Regrava os artefatos guardados e repete as mensagens de erro como o
+    // montador as teria impresso.
+    void restore_from_cache(const CacheEntry &entry, const string &input_filename, Logger &logger)
+    {
+        LOG_INFO(logger, "Entrada sem alteracoes: restaurando do cache...");
+        if (!entry.errors.empty())
+        {
+            LOG_ERROR(logger, "Erros encontrados durante a montagem:");
+            for (const auto &err : entry.errors)
+            {
+                LOG_ERROR(logger, "Linha " << err.first << ": " << err.second);
+            }
+        }
+        for (const auto &file : entry.files)
+        {
+            string filename = change_extension(input_filename, file.first);
+            ofstream out(filename, ios::binary | ios::trunc);
+            out.write(file.second.data(), static_cast<streamsize>(file.second.size()));
+            if (!out)
+            {
+                throw runtime_error("Nao foi possivel criar o arquivo: " + filename);
+            }
+            LOG_INFO(logger, "Restaurado do cache: " << filename);
+        }
+    }
+
+    // Guarda os artefatos recém-gerados. Falhar aqui não falha a compilação.
+    void store_in_cache(BuildCache &cache, const string &key, const vector<pair<int, string>> &errors,
+                        const string &input_filename, const CompileOptions &options, Logger &logger)
+    {
+        try
+        {
+            CacheEntry entry;
+            entry.errors = errors;
+            for (const auto &file : artifacts(input_filename, options))
+            {
+                entry.files.push_back({file.first, read_file_contents(file.second)});
+            }
+            cache.store(key, entry);
+        }
+        catch (const exception &e)
+        {
+            LOG_INFO(logger, "Cache nao atualizado: " << e.what());
+        }
+    }
+
+    // Pré-processa e monta de fato, no modo pedido em `options`. Lê o fonte
+    // de `source` se dado (o buffer de onde saiu a chave do cache) ou do
+    // arquivo. Devolve a lista de erros do montador; `stoppedEarly` diz se a
+    // montagem parou no limite de --max-errors (sem gravar os objetos).
+    vector<pair<int, string>> assemble_file(const string &input_filename, SourceBuffer *source,
+                                             const CompileOptions &options, Logger &logger, CompileStats *stats,
+                                             bool &stoppedEarly)
+    {
+        string pre_filename = change_extension(input_filename, ".pre");
+        string o1_filename = change_extension(input_filename, ".o1");
+        string o2_filename = change_extension(input_filename, ".o2");
+
+        // O pré-processador entrega as linhas expandidas direto ao montador.
+        // O .pre, quando pedido, é só uma cópia lateral dessa saída, na caixa
+        // do fonte.
+        bool writePre = options.writePre && !options.checkOnly;
+        unique_ptr<FileLineSink> pre_file;
+        if (writePre)
+        {
+            pre_file = make_unique<FileLineSink>(pre_filename);
+        }
+        Preprocessor preprocessor(logger, options.macroLimits);
+        Assembler assembler(logger);
+        preprocessor.set_stats(stats);
+        preprocessor.set_pre_output(pre_file.get());
+        assembler.set_stats(stats);
+        assembler.set_optimize(options.optimize);
+        assembler.set_max_errors(options.maxErrors);
+        assembler.set_check_only(options.checkOnly);
+        // Todas as linhas vêm do pré-processador, já em maiúsculas.
+        assembler.set_folded_input(true);
+        if (options.writeBinary)
+        {
+            assembler.set_binary_output(change_extension(input_filename, ".obj"));
+        }
+        auto preprocess = [&](LineSink &sink)
+        {
+            if (source)
+                preprocessor.process(*source, sink);
+            else
+                preprocessor.process(input_filename, sink);
+        };
+
+        if (options.splitJobs > 1)
+        {
+            // A montagem em blocos precisa do programa inteiro em memória.
+            LOG_INFO(logger, "Iniciando Pre-processamento...");
+            MemoryLines lines;
+            preprocess(lines);
+            LOG_INFO(logger, "Pre-processamento concluido.");
+
+            LOG_INFO(logger, "Iniciando Montagem em blocos paralelos (" << options.splitJobs << " threads)...");
+            assembler.assemble_parallel(lines.lines(), options.splitJobs, o1_filename, o2_filename);
+        }
+        else if (options.threaded)
+        {
+            // Pipeline em duas threads ligadas por uma fila limitada.
+            LineQueue queue;
+
+            LOG_INFO(logger, "Iniciando Pre-processamento e Passagem 1: Montagem...");
+            thread producer([&]
+                            {
+                try {
+                    preprocess(queue);
+                } catch (...) {
+                    // A falha chega ao montador pela fila, antes de gerar os objetos.
+                    queue.fail(current_exception());
+                } });
+
+            try
+            {
+                assembler.assemble(queue, o1_filename, o2_filename);
+            }
+            catch (...)
+            {
+                queue.cancel();
+                producer.join();
+                throw;
+            }
+            // Parou no limite de erros: o resto da saída do pré-processador é descartado.
+            if (assembler.stopped_early())
+            {
+                queue.cancel();
+            }
+            producer.join();
+            if (stats)
+            {
+                stats->peakQueuedBatches = queue.peak_batches();
+            }
+        }
+        else
+        {
+            // Pré-processamento
+            LOG_INFO(logger, "Iniciando Pre-processamento...");
+            MemoryLines lines;
+            preprocess(lines);
+            LOG_INFO(logger, "Pre-processamento concluido.");
+
+            // Executa a Passagem 1: Montagem.
+            LOG_INFO(logger, "Iniciando Passagem 1: Montagem...");
+            assembler.assemble(lines, o1_filename, o2_filename);
+        }
+        if (writePre)
+        {
+            LOG_INFO(logger, "Saida do pre-processamento em: " << pre_filename);
+        }
+        stoppedEarly = assembler.stopped_early();
+        return assembler.getErrors();
+    }
+}
+
+CompileResult compile_file(const string &input_filename, const CompileOptions &options, ostream &log)
+{
+    CompileResult result;
+    result.input = input_filename;
+
+    Logger logger(log, options.logLevel, options.traceFile);
+    CompileStats *stats = options.collectStats ? &result.stats : nullptr;
+    PhaseClock totalClock(stats ? &result.stats.total : nullptr);
+    try
+    {
+        // Pipes e afins não entram no cache: seriam consumidos pelo hash. A
+        // chave vem de uma cópia do fonte em memória, e é essa cópia que é
+        // montada: se o arquivo mudar no meio, os artefatos continuam
+        // correspondendo à chave.
+        string cacheKey;
+        CacheEntry entry;
+        unique_ptr<SourceBuffer> source;
+        error_code ec;
+        if (options.cache && !options.checkOnly && filesystem::is_regular_file(input_filename, ec))
+        {
+            source = make_unique<SourceBuffer>(input_filename, true);
+            cacheKey = options.cache->key(source->text(), cache_config(options));
+        }
+        if (!cacheKey.empty() && options.cache->load(cacheKey, entry))
+        {
+            restore_from_cache(entry, input_filename, logger);
+            result.errorCount = entry.errors.size();
+            result.cached = true;
+            if (stats)
+            {
+                stats->cacheHits++;
+                stats->errors += entry.errors.size();
+            }
+        }
+        else
+        {
+            vector<pair<int, string>> errors =
+                assemble_file(input_filename, source.get(), options, logger, stats, result.stoppedEarly);
+            result.errorCount = errors.size();
+            // Sem os objetos não há o que guardar.
+            if (!cacheKey.empty() && !result.stoppedEarly)
+            {
+                store_in_cache(*options.cache, cacheKey, errors, input_filename, options, logger);
+            }
+        }
+    }
+    catch (const exception &e)
+    {
+        LOG_ERROR(logger, "Erro fatal durante a compilacao: " << e.what());
+        result.fatal = true;
+    }
+    if (stats)
+    {
+        // O tempo de CPU e as alocações do total somam as fases, que podem
+        // rodar em threads diferentes.
+        totalClock.stop();
+        stats->total.cpu = stats->preprocess.cpu + stats->tokenize.cpu + stats->encode.cpu + stats->write.cpu;
+        stats->total.heap = stats->preprocess.heap;
+        stats->total.heap += stats->tokenize.heap;
+        stats->total.heap += stats->encode.heap;
+        stats->total.heap += stats->write.heap;
+    }
+    return result;
+}
+
+vector<string> collect_inputs(const vector<string> &paths)
+{
+    namespace fs = std::filesystem;
+    vector<string> inputs;
+    for (const string &path : paths)
+    {
+        error_code ec;
+        if (fs::is_directory(path, ec))
+        {
+            vector<string> found;
+            for (const auto &entry : fs::directory_iterator(path))
+            {
+                if (entry.is_regular_file() && entry.path().extension() == ".asm")
+                {
+                    found.push_back(entry.path().string());
+                }
+            }
+            sort(found.begin(), found.end());
+            inputs.insert(inputs.end(), found.begin(), found.end());
+        }
+        else
+        {
+            inputs.push_back(path);
+        }
+    }
+    return inputs;
+}
+
+vector<CompileResult> compile_batch(const vector<string> &inputs, const CompileOptions &options, unsigned jobs, ostream &out)
+{
+    vector<CompileResult> results(inputs.size());
+    vector<string> logs(inputs.size());
+    vector<char> done(inputs.size(), 0);
+    atomic<size_t> nextJob{0};
+    mutex lock;
+    condition_variable finished;
+
+    // Cada worker pega o próximo arquivo da lista até acabar.
+    auto worker = [&]
+    {
+        while (true)
+        {
+            size_t job = nextJob.fetch_add(1);
+            if (job >= inputs.size())
+                break;
+            ostringstream log;
+            CompileResult result = compile_file(inputs[job], options, log);
+            lock_guard<mutex> guard(lock);
+            results[job] = result;
+            logs[job] = log.str();
+            done[job] = 1;
+            finished.notify_one();
+        }
+    };
+
+    jobs = max(1u, min<unsigned>(jobs, static_cast<unsigned>(inputs.size())));
+    vector<thread> pool;
+    for (unsigned i = 0; i < jobs; i++)
+    {
+        pool.emplace_back(worker);
+    }
+
+    // Imprime as mensagens na ordem de entrada, assim que cada arquivo termina.
+    for (size_t job = 0; job < inputs.size(); job++)
+    {
+        unique_lock<mutex> guard(lock);
+        finished.wait(guard, [&]
+                      { return done[job] != 0; });
+        string text = std::move(logs[job]);
+        guard.unlock();
+        out << "==> " << inputs[job] << "\n"
+            << text;
+    }
+    out.flush();
+
+    for (thread &t : pool)
+    {
+        t.join();
+    }
+    return results;
+}
@@ -0,0 +1,64 @@
+#ifndef DRIVER_HPP
+#define DRIVER_HPP
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "Preprocessor.hpp"
+#include "Log.hpp"
+#include "Stats.hpp"
+#include "BuildCache.hpp"
+
+using namespace std;
+
+// Versão dos artefatos gerados, parte da chave do cache de compilação. Mude a
+// cada alteração no pré-processador/montador que mude o .pre, .o1, .o2 ou .obj.
+inline constexpr const char* ASSEMBLER_VERSION = "4";
+
+// Opções de uma compilação (pré-processamento + montagem) de um arquivo.
+struct CompileOptions {
+    bool writePre = true;   // grava o .pre como saída lateral
+    bool threaded = true;   // pré-processador e montador em duas threads
+    unsigned splitJobs = 0; // > 1: monta um arquivo grande em blocos paralelos
+    bool writeBinary = false; // também gera o objeto binário .obj
+    MacroLimits macroLimits;  // limites de profundidade/tamanho da expansão de macros
+    LogLevel logLevel = LogLevel::INFO;
+    TraceFile* traceFile = nullptr; // destino do trace; nulo: junto com o log
+    bool optimize = false;     // otimizador peephole (-O)
+    bool collectStats = false; // mede tempos por fase e contadores (--stats)
+    BuildCache* cache = nullptr; // reaproveita compilações anteriores; nulo: --no-cache
+    size_t maxErrors = 0;      // para a montagem no N-ésimo erro (--max-errors); 0: sem limite
+    bool checkOnly = false;    // só verifica (--check): nenhum arquivo gerado, sem cache
+};
+
+struct CompileResult {
+    string input;
+    bool fatal = false;     // exceção (arquivo inexistente, erro de E/S...)
+    size_t errorCount = 0;  // erros léxicos/semânticos reportados pelo montador
+    bool cached = false;    // artefatos restaurados do cache, sem montar
+    bool stoppedEarly = false; // parou no limite de --max-errors, sem gravar os objetos
+    CompileStats stats;     // preenchido só com options.collectStats
+
+    bool ok() const { return !fatal && errorCount == 0; }
+};
+
+string change_extension(const string& filename, const string& new_ext);
+
+// Pré-processa e monta `input_filename`, gerando .pre/.o1/.o2 ao lado dele.
+// Todas as mensagens (inclusive o erro fatal) vão para `log`, filtradas por
+// options.logLevel. Com options.cache, uma entrada com o mesmo conteúdo e as
+// mesmas opções é restaurada sem rodar o pré-processador nem o montador, e
+// uma compilação sem erro fatal é guardada no cache. Com options.checkOnly só
+// as mensagens de erro são produzidas.
+CompileResult compile_file(const string& input_filename, const CompileOptions& options, ostream& log);
+
+// Expande os argumentos em uma lista de arquivos: diretórios viram os seus
+// arquivos .asm em ordem alfabética; os demais caminhos são mantidos na ordem dada.
+vector<string> collect_inputs(const vector<string>& paths);
+
+// Monta vários arquivos em paralelo com `jobs` threads. Cada arquivo usa o
+// seu próprio Preprocessor/Assembler e as mensagens são impressas em `out`
+// na ordem de entrada. Retorna os resultados na mesma ordem.
+vector<CompileResult> compile_batch(const vector<string>& inputs, const CompileOptions& options, unsigned jobs, ostream& out);
+
+#endif // DRIVER_HPP
@@ -0,0 +1,35 @@
+#ifndef FIXUP_TABLE_HPP
+#define FIXUP_TABLE_HPP
+
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+// Tabela de pendências (referências a rótulos ainda não definidos) guardada em
+// colunas contíguas (struct-of-arrays): a i-ésima pendência é
+// (slot[i], symbol[i], offset[i]). O montador adiciona as entradas na ordem em
+// que emite o código, logo `slot` fica em ordem crescente.
+struct FixupTable {
+    vector<int> slot;       // posição no codigoObjeto
+    vector<int> symbol;     // ID do símbolo na SymbolTable
+    vector<int> offset;     // offset de LABEL+offset
+
+    void add(int at, int symbolId, int off)
+    {
+        slot.push_back(at);
+        symbol.push_back(symbolId);
+        offset.push_back(off);
+    }
+
+    size_t size() const { return slot.size(); }
+
+    void clear()
+    {
+        slot.clear();
+        symbol.clear();
+        offset.clear();
+    }
+};
+
+#endif // FIXUP_TABLE_HPP
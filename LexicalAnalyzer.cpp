@@ -1,119 +1,164 @@
 #include "LexicalAnalyzer.hpp"
+#include "OpTable.hpp"
 #include <cctype>
-#include <sstream>
 #include <algorithm>
-#include <iostream>
 
 using namespace std;
 
-vector<Token> LexicalAnalyzer::tokenize(const string &source, int line)
+namespace
 {
-    vector<Token> tokens;
-    // Replace commas with spaces so stringstream splits on commas as separators
-    string sanitized = source;
-    replace(sanitized.begin(), sanitized.end(), ',', ' ');
-    // Remove spaces around '+' so expressions like "N2 + 3" become "N2+3"
-    string compact;
-    for (size_t i = 0; i < sanitized.size(); ++i)
+    bool isSpace(char c)
     {
-        char c = sanitized[i];
-        if (isspace(static_cast<unsigned char>(c)))
-        {
-            bool nextIsPlus = (i + 1 < sanitized.size() && sanitized[i + 1] == '+');
-            bool prevIsPlus = (i > 0 && sanitized[i - 1] == '+');
-            if (nextIsPlus || prevIsPlus)
-                continue; // skip spaces adjacent to plus
-        }
-        compact.push_back(c);
+        return isspace(static_cast<unsigned char>(c)) != 0;
     }
-    stringstream stream(compact);
-    string word;
 
-    while (stream >> word)
+    bool isNumber(string_view word)
     {
-        Token token;
-        token.lineNumber = line;
+        return !word.empty() && all_of(word.begin(), word.end(), [](char c)
+                                       { return isdigit(static_cast<unsigned char>(c)) != 0; });
+    }
 
-        if (word == ";") {
-            break; // Ignore the rest of the line as it's a comment
-        }
+    string_view trim(string_view s)
+    {
+        while (!s.empty() && isSpace(s.front()))
+            s.remove_prefix(1);
+        while (!s.empty() && isSpace(s.back()))
+            s.remove_suffix(1);
+        return s;
+    }
+}
+
+vector<Token> LexicalAnalyzer::tokenize(string_view source, int line)
+{
+    vector<Token> tokens;
+    tokenize(source, line, tokens);
+    return tokens;
+}
+
+void LexicalAnalyzer::tokenize(string_view source, int line, vector<Token> &tokens)
+{
+    LexicalError error;
+    if (!scan(source, line, tokens, error))
+        throw LexicalException(lexical_message(error.code, error.text), line);
+}
 
-        if (!word.empty())
+bool LexicalAnalyzer::scan(string_view source, int line, vector<Token> &tokens, LexicalError &error)
+{
+    tokens.clear();
+    const size_t n = source.size();
+    size_t i = 0;
+
+    while (true)
+    {
+        // Vírgulas funcionam como separadores, assim como espaços.
+        while (i < n && (isSpace(source[i]) || source[i] == ','))
+            i++;
+        // ';' inicia um comentário: ignora o resto da linha.
+        if (i >= n || source[i] == ';')
+            break;
+
+        size_t start = i;
+        size_t end = i;
+        size_t plusPos = string_view::npos;
+        while (true)
         {
-            if (word.back() == ':')
+            while (i < n && !isSpace(source[i]) && source[i] != ',' && source[i] != ';')
             {
-                word.pop_back();
-                if (!isValidLabel(word))
-                {
-                    throw LexicalException("Rótulo inválido: " + word, line);
-                }
-                token.type = TokenType::LABEL;
-                token.value = word;
+                if (source[i] == '+' && plusPos == string_view::npos)
+                    plusPos = i;
+                i++;
             }
-            else if (word == "SPACE" || word == "CONST")
+            end = i;
+
+            // Espaços ao redor de '+' não separam tokens: "N2 + 3" == "N2+3".
+            size_t j = i;
+            while (j < n && isSpace(source[j]))
+                j++;
+            bool joinsNext = j < n && source[j] == '+';
+            bool endsWithPlus = end > start && source[end - 1] == '+';
+            if (j > i && j < n && source[j] != ',' && source[j] != ';' && (joinsNext || endsWithPlus))
             {
-                // Não trata macros pq são excluídas no pré-processamento
-                token.type = TokenType::DIRECTIVE;
-                token.value = word;
+                i = j;
+                continue;
             }
-            else if (
-                // Acha o token e retorna o indice ou retorna o último elemento
-                find(optab.begin(), optab.end(), word) != optab.end())
+            break;
+        }
+
+        string_view word = source.substr(start, end - start);
+        Token token;
+        token.lineNumber = line;
+        token.value = word;
+        token.base = word;
+
+        if (word.back() == ':')
+        {
+            word.remove_suffix(1);
+            if (!isValidLabel(word))
             {
-                token.type = TokenType::INSTRUCTION;
-                token.value = word;
+                error = {DiagCode::INVALID_LABEL, word};
+                return false;
             }
-            else if (all_of(word.begin(), word.end(), ::isdigit))
+            token.type = TokenType::LABEL;
+            token.value = word;
+            token.base = word;
+        }
+        else if (const OpInfo *op = find_op(word))
+        {
+            // Instruções e diretivas vêm da mesma OPTAB.
+            // Não trata macros pq são excluídas no pré-processamento
+            token.type = op->kind == OpKind::DIRECTIVE ? TokenType::DIRECTIVE : TokenType::INSTRUCTION;
+            token.op = op;
+        }
+        else if (isNumber(word))
+        {
+            token.type = TokenType::NUMBER;
+        }
+        else
+        {
+            // Token desconhecido, assume como PARAMETER (pode ser um rótulo ou variável)
+            token.type = TokenType::PARAMETER;
+
+            // Valida parameteros nos formatos: LABEL, LABEL+NUMBER, NUMBER+NUMBER, etc.
+            if (plusPos != string_view::npos)
             {
-                token.type = TokenType::NUMBER;
-                token.value = word;
+                string_view left = trim(source.substr(start, plusPos - start));
+                string_view right = trim(source.substr(plusPos + 1, end - plusPos - 1));
+                bool leftValid = !left.empty() && (isValidLabel(left) || isNumber(left));
+                bool rightValid = isNumber(right);
+                if (!leftValid || !rightValid)
+                {
+                    error = {DiagCode::INVALID_OPERAND_TOKEN, word};
+                    return false;
+                }
+                token.base = left;
+                token.offset = right;
             }
             else
             {
-                // Token desconhecido, assume como PARAMETER (pode ser um rótulo ou variável)
-                token.type = TokenType::PARAMETER;
-                token.value = word;
-
-                // Valida parameteros nos formatos: LABEL, LABEL+NUMBER, NUMBER+NUMBER, etc.
-                size_t plusPos = word.find('+');
-                if (plusPos != string::npos)
-                {
-                    string left = word.substr(0, plusPos);
-                    string right = word.substr(plusPos + 1);
-                    bool leftValid = !left.empty() && (isValidLabel(left) || all_of(left.begin(), left.end(), ::isdigit));
-                    bool rightValid = !right.empty() && all_of(right.begin(), right.end(), ::isdigit);
-                    if (!leftValid || !rightValid)
-                    {
-                        throw LexicalException("Parametero ou rótulo inválido: " + word, line);
-                    }
-                }
-                else
+                if (!isValidLabel(word))
                 {
-                    if (!isValidLabel(word))
-                    {
-                        throw LexicalException("Parametero ou rótulo inválido: " + word, line);
-                    }
+                    error = {DiagCode::INVALID_OPERAND_TOKEN, word};
+                    return false;
                 }
             }
-
-            tokens.push_back(token); 
         }
 
+        tokens.push_back(token);
     }
-    return tokens;
+    return true;
 }
 
-bool LexicalAnalyzer::isValidLabel(const string &label)
+bool LexicalAnalyzer::isValidLabel(string_view label)
 {
     if (label.empty())
         return false;
 
-    if (!isalpha(label[0]) && label[0] != '_')
+    if (!isalpha(static_cast<unsigned char>(label[0])) && label[0] != '_')
         return false;
 
     for (size_t i = 1; i < label.size(); i++)
     {
-        if (!isalnum(label[i]) && label[i] != '_')
+        if (!isalnum(static_cast<unsigned char>(label[i])) && label[i] != '_')
         {
             return false;
         }
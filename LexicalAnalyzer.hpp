@@ -2,24 +2,34 @@
 #define LEXICAL_ANALYZER_HPP
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <stdexcept>
+#include "Diagnostic.hpp"
 #include "Token.hpp"
 
 using namespace std;
 
+// Erro léxico devolvido por LexicalAnalyzer::scan: `text` é o token inválido
+// (view sobre a linha).
+struct LexicalError {
+    DiagCode code;
+    string_view text;
+};
+
 class LexicalAnalyzer {
 public:
-    vector<Token> tokenize(const string& source, int line);
+    // Varre a linha uma única vez e preenche `tokens` (limpo antes) com views
+    // sobre `source`. Reaproveitar o mesmo vetor entre linhas evita alocações.
+    // Num token inválido para e devolve false com o erro em `error`, sem lançar
+    // exceção (é o caminho do montador).
+    bool scan(string_view source, int line, vector<Token>& tokens, LexicalError& error);
+    // Como scan, mas lança LexicalException no token inválido.
+    void tokenize(string_view source, int line, vector<Token>& tokens);
+    vector<Token> tokenize(string_view source, int line);
 
 private:
-    bool isValidLabel(const string& label);
-    vector<string> optab = {
-        "ADD", "SUB", "MULT", "DIV", "JMP", "JMPN", "JMPP", "JMPZ",
-        "COPY", "LOAD", "STORE", "INPUT", "OUTPUT", "STOP"
-    };
-    string source;
-    size_t currentPos;
+    bool isValidLabel(string_view label);
 };
 
 class LexicalException : public runtime_error {
@@ -31,4 +41,4 @@ private:
     int lineNumber;
 };
 
-#endif // LEXICAL_ANALYZER_HPP
\ No newline at end of file
+#endif // LEXICAL_ANALYZER_HPP
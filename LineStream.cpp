@@ -0,0 +1,132 @@
+#include "LineStream.hpp"
+#include <stdexcept>
+#include <algorithm>
+
+using namespace std;
+
+FileLineSink::FileLineSink(const string &filename) : file(filename)
+{
+    if (!file.is_open())
+    {
+        throw runtime_error("Nao foi possivel abrir o arquivo de saida: " + filename);
+    }
+}
+
+void FileLineSink::write(string_view line)
+{
+    file.write(line.data(), line.size());
+    file.put('\n');
+}
+
+void FileLineSink::close()
+{
+    file.close();
+}
+
+bool FileLineSource::next(string_view &line)
+{
+    if (nextLine >= buffer.lineCount())
+        return false;
+    line = buffer.line(nextLine++);
+    return true;
+}
+
+void TeeLineSink::write(string_view line)
+{
+    first.write(line);
+    second.write(line);
+}
+
+void TeeLineSink::close()
+{
+    first.close();
+    second.close();
+}
+
+void MemoryLines::write(string_view line)
+{
+    buffer.text.append(line);
+    buffer.ends.push_back(buffer.text.size());
+}
+
+bool MemoryLines::next(string_view &line)
+{
+    if (readPos >= buffer.size())
+        return false;
+    line = buffer.line(readPos++);
+    return true;
+}
+
+void LineQueue::write(string_view line)
+{
+    producing.text.append(line);
+    producing.ends.push_back(producing.text.size());
+    if (producing.size() >= batchSize)
+        flush_batch();
+}
+
+void LineQueue::flush_batch()
+{
+    size_t batchBytes = producing.text.size();
+    unique_lock<mutex> guard(lock);
+    notFull.wait(guard, [this] { return queued < capacity || cancelled; });
+    if (!cancelled)
+    {
+        // O lote entra no anel; o produtor fica com o que estava na posição
+        // (já lido), para reaproveitar os buffers.
+        swap(producing, ring[(head + queued) % capacity]);
+        queued++;
+        peakBatches = max(peakBatches, queued);
+    }
+    producing.clear();
+    // Na primeira volta do anel os lotes ainda estão vazios: já nascem com o
+    // tamanho do anterior em vez de crescer linha a linha.
+    producing.reserve(batchSize, batchBytes + batchBytes / 4);
+    notEmpty.notify_one();
+}
+
+void LineQueue::close()
+{
+    if (producing.size() > 0)
+        flush_batch();
+    lock_guard<mutex> guard(lock);
+    closed = true;
+    notEmpty.notify_all();
+}
+
+void LineQueue::cancel()
+{
+    lock_guard<mutex> guard(lock);
+    cancelled = true;
+    queued = 0;
+    notFull.notify_all();
+}
+
+void LineQueue::fail(exception_ptr error)
+{
+    lock_guard<mutex> guard(lock);
+    producerError = error;
+    closed = true;
+    notEmpty.notify_all();
+}
+
+bool LineQueue::next(string_view &line)
+{
+    if (consumePos >= consuming.size())
+    {
+        unique_lock<mutex> guard(lock);
+        notEmpty.wait(guard, [this] { return queued > 0 || closed; });
+        if (producerError)
+            rethrow_exception(producerError);
+        if (queued == 0)
+            return false;
+        // O lote lido volta ao anel no lugar do que será lido agora.
+        swap(consuming, ring[head]);
+        head = (head + 1) % capacity;
+        queued--;
+        consumePos = 0;
+        notFull.notify_one();
+    }
+    line = consuming.line(consumePos++);
+    return true;
+}
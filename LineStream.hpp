@@ -0,0 +1,154 @@
+#ifndef LINE_STREAM_HPP
+#define LINE_STREAM_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fstream>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include "SourceBuffer.hpp"
+
+using namespace std;
+
+// Destino de linhas expandidas (saída do pré-processador).
+class LineSink {
+public:
+    virtual ~LineSink() = default;
+    virtual void write(string_view line) = 0;
+    // Sinaliza que não haverá mais linhas.
+    virtual void close() {}
+};
+
+// Origem de linhas (entrada do montador). A view devolvida por next()
+// só é válida até a próxima chamada.
+class LineSource {
+public:
+    virtual ~LineSource() = default;
+    virtual bool next(string_view& line) = 0;
+};
+
+// Escreve as linhas em um arquivo (ex: o .pre).
+class FileLineSink : public LineSink {
+public:
+    explicit FileLineSink(const string& filename);
+    void write(string_view line) override;
+    void close() override;
+
+private:
+    ofstream file;
+};
+
+// Lê as linhas de um arquivo mapeado em memória, sem copiá-las.
+class FileLineSource : public LineSource {
+public:
+    explicit FileLineSource(const string& filename) : buffer(filename) {}
+    bool next(string_view& line) override;
+    const SourceBuffer& source() const { return buffer; }
+
+private:
+    SourceBuffer buffer;
+    size_t nextLine = 0;
+};
+
+// Descarta as linhas (ex: quando só a cópia lateral do .pre interessa).
+class NullLineSink : public LineSink {
+public:
+    void write(string_view) override {}
+};
+
+// Repassa cada linha para dois destinos (ex: montador + arquivo .pre opcional).
+class TeeLineSink : public LineSink {
+public:
+    TeeLineSink(LineSink& first, LineSink& second) : first(first), second(second) {}
+    void write(string_view line) override;
+    void close() override;
+
+private:
+    LineSink& first;
+    LineSink& second;
+};
+
+// Linhas guardadas em bloco: o texto de todas, em sequência, e onde cada uma
+// termina (uma alocação por buffer, não por linha). Esvaziado com clear(),
+// mantém a capacidade.
+struct LineBatch {
+    string text;
+    vector<size_t> ends;
+
+    size_t size() const { return ends.size(); }
+    string_view line(size_t index) const
+    {
+        size_t begin = index == 0 ? 0 : ends[index - 1];
+        return string_view(text).substr(begin, ends[index] - begin);
+    }
+    void clear()
+    {
+        text.clear();
+        ends.clear();
+    }
+    void reserve(size_t lines, size_t bytes)
+    {
+        ends.reserve(lines);
+        text.reserve(bytes);
+    }
+};
+
+// Buffer em memória: pré-processa tudo e depois entrega as linhas ao montador
+// na mesma thread.
+class MemoryLines : public LineSink, public LineSource {
+public:
+    void write(string_view line) override;
+    bool next(string_view& line) override;
+    const LineBatch& lines() const { return buffer; }
+
+private:
+    LineBatch buffer;
+    size_t readPos = 0;
+};
+
+// Fila limitada entre duas threads: o pré-processador produz e o montador
+// consome. As linhas trafegam em lotes para não travar o mutex a cada linha;
+// write() bloqueia quando há `capacity` lotes aguardando consumo. Os lotes
+// ficam num anel fixo e são trocados (swap) com o do produtor e o do
+// consumidor, então os buffers circulam e, depois da primeira volta, a fila
+// não aloca mais nada.
+class LineQueue : public LineSink, public LineSource {
+public:
+    explicit LineQueue(size_t capacity = 64, size_t batchSize = 256)
+        : capacity(capacity), batchSize(batchSize), ring(capacity) {}
+    void write(string_view line) override;
+    void close() override;
+    bool next(string_view& line) override;
+    // Chamado pelo consumidor quando desiste de ler (ex: erro fatal), para
+    // que o produtor não fique bloqueado em write().
+    void cancel();
+    // Chamado pelo produtor quando falha: o consumidor recebe a exceção em next().
+    void fail(exception_ptr error);
+    // Maior número de lotes que ficaram aguardando consumo ao mesmo tempo.
+    size_t peak_batches() const { return peakBatches; }
+
+private:
+    void flush_batch();
+
+    size_t capacity;
+    size_t batchSize;
+    // Lotes aguardando consumo: `queued` lotes a partir de ring[head].
+    vector<LineBatch> ring;
+    size_t head = 0;
+    size_t queued = 0;
+    size_t peakBatches = 0;
+    bool closed = false;
+    bool cancelled = false;
+    exception_ptr producerError;
+    // Lote sendo preenchido pelo produtor e lote sendo lido pelo consumidor.
+    LineBatch producing;
+    LineBatch consuming;
+    size_t consumePos = 0;
+    mutex lock;
+    condition_variable notFull;
+    condition_variable notEmpty;
+};
+
+#endif // LINE_STREAM_HPP
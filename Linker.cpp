@@ -0,0 +1,154 @@
+#include "Linker.hpp"
+#include "Loader.hpp"
+#include "Parallel.hpp"
+#include <algorithm>
+#include <functional>
+#include <string_view>
+#include <unordered_map>
+
+using namespace std;
+
+namespace
+{
+    // Definição (PUBLIC) ou uso (cadeia da tabela de uso) de um módulo.
+    struct SymbolRefInModule {
+        uint32_t module;
+        uint32_t index; // na tabela de definições ou de uso do módulo
+    };
+
+    // Erro com a posição em que aparece (módulo, tabela, índice), para
+    // ordenar as mensagens.
+    struct LinkError {
+        uint32_t module;
+        uint32_t index;
+        string message;
+    };
+
+    size_t partition_of(string_view name, size_t partitions)
+    {
+        return hash<string_view>{}(name) % partitions;
+    }
+}
+
+LinkResult link_objects(const vector<ObjectImage> &modules, const vector<string> &names, unsigned jobs)
+{
+    const size_t moduleCount = modules.size();
+    const size_t partitions = max(1u, jobs);
+    LinkResult result;
+
+    // Endereço de carga de cada módulo (soma de prefixo dos tamanhos).
+    vector<int> base(moduleCount);
+    size_t total = 0;
+    for (size_t m = 0; m < moduleCount; m++)
+    {
+        base[m] = static_cast<int>(total);
+        total += modules[m].words.size();
+    }
+
+    // Fase 1 (paralela por módulo): distribui definições e usos pelas
+    // partições do nome.
+    vector<vector<vector<SymbolRefInModule>>> definitions(moduleCount, vector<vector<SymbolRefInModule>>(partitions));
+    vector<vector<vector<SymbolRefInModule>>> uses(moduleCount, vector<vector<SymbolRefInModule>>(partitions));
+    parallel_for(moduleCount, jobs, [&](size_t m)
+                 {
+        const ObjectImage &module = modules[m];
+        for (size_t i = 0; i < module.definitions.size(); i++)
+            definitions[m][partition_of(module.definitions[i].symbol, partitions)].push_back(
+                {static_cast<uint32_t>(m), static_cast<uint32_t>(i)});
+        for (size_t i = 0; i < module.pending.size(); i++)
+            uses[m][partition_of(module.pending[i].symbol, partitions)].push_back(
+                {static_cast<uint32_t>(m), static_cast<uint32_t>(i)}); });
+
+    // Fase 2 (paralela por partição): cada partição monta a sua parte da
+    // tabela global (em ordem de módulo, então a primeira definição vence) e
+    // resolve os usos dos seus nomes. resolved[m][i]: endereço final do
+    // símbolo da cadeia i do módulo m, ou -1.
+    vector<vector<int>> resolved(moduleCount);
+    for (size_t m = 0; m < moduleCount; m++)
+        resolved[m].assign(modules[m].pending.size(), -1);
+    vector<vector<LinkError>> duplicateErrors(partitions);
+    vector<vector<LinkError>> undefinedErrors(partitions);
+    parallel_for(partitions, jobs, [&](size_t p)
+                 {
+        unordered_map<string_view, SymbolRefInModule> table;
+        for (size_t m = 0; m < moduleCount; m++)
+        {
+            for (const SymbolRefInModule &ref : definitions[m][p])
+            {
+                const string &symbol = modules[m].definitions[ref.index].symbol;
+                auto [it, inserted] = table.try_emplace(symbol, ref);
+                if (!inserted)
+                    duplicateErrors[p].push_back({ref.module, ref.index,
+                                                  "Simbolo '" + symbol + "' definido em " + names[it->second.module] +
+                                                      " e em " + names[m] + "."});
+            }
+        }
+        for (size_t m = 0; m < moduleCount; m++)
+        {
+            for (const SymbolRefInModule &ref : uses[m][p])
+            {
+                const string &symbol = modules[m].pending[ref.index].symbol;
+                auto it = table.find(symbol);
+                if (it == table.end())
+                {
+                    undefinedErrors[p].push_back({ref.module, ref.index,
+                                                  "Simbolo '" + symbol + "' usado em " + names[m] +
+                                                      " nao e definido por nenhum modulo."});
+                    continue;
+                }
+                const SymbolRefInModule &definition = it->second;
+                resolved[m][ref.index] = base[definition.module] + modules[definition.module].definitions[definition.index].address;
+            }
+        } });
+
+    for (auto *errors : {&duplicateErrors, &undefinedErrors})
+    {
+        vector<LinkError> all;
+        for (vector<LinkError> &partition : *errors)
+            all.insert(all.end(), make_move_iterator(partition.begin()), make_move_iterator(partition.end()));
+        sort(all.begin(), all.end(), [](const LinkError &a, const LinkError &b)
+             { return a.module != b.module ? a.module < b.module : a.index < b.index; });
+        for (LinkError &error : all)
+            result.errors.push_back(std::move(error.message));
+    }
+    if (!result.ok())
+        return result;
+
+    // Fase 3 (paralela por módulo): copia o código para o endereço de carga,
+    // reloca com o mapa do módulo (relocate_words) e percorre a tabela de uso.
+    // As posições preenchidas com símbolos também passam a ser relocáveis.
+    ObjectImage &image = result.image;
+    image.words.resize(total);
+    image.entryPoint = moduleCount > 0 ? modules[0].entryPoint : 0;
+    vector<vector<int>> usedSlots(moduleCount);
+    parallel_for(moduleCount, jobs, [&](size_t m)
+                 {
+        const ObjectImage &module = modules[m];
+        int *words = image.words.data() + base[m];
+        copy(module.words.begin(), module.words.end(), words);
+        if (!module.relocationMap.empty())
+            relocate_words(words, module.words.size(), module.relocationMap.data(), base[m]);
+        for (size_t i = 0; i < module.pending.size(); i++)
+        {
+            for (const FixupSite &site : module.pending[i].sites)
+            {
+                words[site.slot] = resolved[m][i] + site.offset;
+                usedSlots[m].push_back(site.slot);
+            }
+        } });
+
+    // Mapa do programa ligado: os mapas dos módulos deslocados para o endereço
+    // de carga, mais as posições da tabela de uso.
+    for (size_t m = 0; m < moduleCount; m++)
+    {
+        const ObjectImage &module = modules[m];
+        for (size_t slot = 0; slot < module.words.size(); slot++)
+        {
+            if (module.isRelocated(slot))
+                image.markRelocated(base[m] + slot);
+        }
+        for (int slot : usedSlots[m])
+            image.markRelocated(static_cast<size_t>(base[m] + slot));
+    }
+    return result;
+}
@@ -0,0 +1,27 @@
+#ifndef LINKER_HPP
+#define LINKER_HPP
+
+#include <string>
+#include <vector>
+#include "ObjectFile.hpp"
+
+using namespace std;
+
+// Resultado de link_objects.
+struct LinkResult {
+    ObjectImage image;      // programa ligado (sem pendências), a partir do endereço 0
+    vector<string> errors;  // símbolos duplicados ou não definidos; vazio se ligou
+
+    bool ok() const { return errors.empty(); }
+};
+
+// Liga os módulos na ordem dada: o módulo i é carregado logo depois do i-1, as
+// suas relocações recebem o endereço de carga e cada cadeia da tabela de uso
+// recebe o endereço do símbolo na tabela de definições de quem o exporta.
+// A tabela global de símbolos é dividida em partições pelo hash do nome,
+// construídas e consultadas em paralelo (`jobs` threads); as mensagens de erro
+// saem na ordem dos módulos, independentemente do número de threads.
+// `names` identifica os módulos nas mensagens.
+LinkResult link_objects(const vector<ObjectImage>& modules, const vector<string>& names, unsigned jobs);
+
+#endif // LINKER_HPP
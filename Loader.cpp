@@ -0,0 +1,163 @@
+#include "Loader.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__) && defined(__SSE2__) && !defined(LOADER_SCALAR)
+#define LOADER_X86 1
+#include <immintrin.h>
+#else
+#define LOADER_X86 0
+#endif
+
+using namespace std;
+
+static_assert(sizeof(int) == 4, "o loader supoe words de 32 bits");
+
+namespace
+{
+    // Words [i, count) uma a uma; o add é feito em unsigned para não ter
+    // overflow de int.
+    void relocate_tail(int *words, size_t i, size_t count, const uint8_t *relocationMap, int base)
+    {
+        for (; i < count; i++)
+        {
+            uint32_t mask = 0u - ((relocationMap[i / 8] >> (i % 8)) & 1u);
+            words[i] = static_cast<int>(static_cast<uint32_t>(words[i]) + (static_cast<uint32_t>(base) & mask));
+        }
+    }
+
+#if LOADER_X86
+    // Máscara de 64 bits do mapa a partir da word `i` (múltiplo de 64).
+    uint64_t map_block(const uint8_t *relocationMap, size_t i)
+    {
+        uint64_t block;
+        memcpy(&block, relocationMap + i / 8, sizeof(block));
+        return block;
+    }
+
+    void relocate_sse2(int *words, size_t count, const uint8_t *relocationMap, int base)
+    {
+        const __m128i lowBits = _mm_setr_epi32(1, 2, 4, 8);
+        const __m128i highBits = _mm_setr_epi32(16, 32, 64, 128);
+        const __m128i addend = _mm_set1_epi32(base);
+        size_t i = 0;
+        for (; i + 64 <= count; i += 64)
+        {
+            if (map_block(relocationMap, i) == 0)
+                continue;
+            for (size_t j = i; j < i + 64; j += 8)
+            {
+                int byte = relocationMap[j / 8];
+                if (byte == 0)
+                    continue;
+                __m128i broadcast = _mm_set1_epi32(byte);
+                __m128i lowMask = _mm_cmpeq_epi32(_mm_and_si128(broadcast, lowBits), lowBits);
+                __m128i highMask = _mm_cmpeq_epi32(_mm_and_si128(broadcast, highBits), highBits);
+                __m128i *low = reinterpret_cast<__m128i *>(words + j);
+                __m128i *high = reinterpret_cast<__m128i *>(words + j + 4);
+                _mm_storeu_si128(low, _mm_add_epi32(_mm_loadu_si128(low), _mm_and_si128(lowMask, addend)));
+                _mm_storeu_si128(high, _mm_add_epi32(_mm_loadu_si128(high), _mm_and_si128(highMask, addend)));
+            }
+        }
+        relocate_tail(words, i, count, relocationMap, base);
+    }
+
+    __attribute__((target("avx2"))) void relocate_avx2(int *words, size_t count, const uint8_t *relocationMap, int base)
+    {
+        const __m256i bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+        const __m256i addend = _mm256_set1_epi32(base);
+        size_t i = 0;
+        for (; i + 64 <= count; i += 64)
+        {
+            if (map_block(relocationMap, i) == 0)
+                continue;
+            for (size_t j = i; j < i + 64; j += 8)
+            {
+                int byte = relocationMap[j / 8];
+                if (byte == 0)
+                    continue;
+                __m256i mask = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(byte), bits), bits);
+                __m256i *lanes = reinterpret_cast<__m256i *>(words + j);
+                _mm256_storeu_si256(lanes, _mm256_add_epi32(_mm256_loadu_si256(lanes), _mm256_and_si256(mask, addend)));
+            }
+        }
+        relocate_tail(words, i, count, relocationMap, base);
+    }
+
+    bool has_avx2()
+    {
+        static const bool supported = __builtin_cpu_supports("avx2");
+        return supported;
+    }
+
+    // AVX2 quando o processador tem, a menos que set_relocation_backend("sse2").
+    bool &use_avx2()
+    {
+        static bool selected = has_avx2();
+        return selected;
+    }
+#endif
+}
+
+void relocate_words_scalar(int *words, size_t count, const uint8_t *relocationMap, int base)
+{
+    relocate_tail(words, 0, count, relocationMap, base);
+}
+
+void relocate_words(int *words, size_t count, const uint8_t *relocationMap, int base)
+{
+#if LOADER_X86
+    if (use_avx2())
+        relocate_avx2(words, count, relocationMap, base);
+    else
+        relocate_sse2(words, count, relocationMap, base);
+#else
+    relocate_words_scalar(words, count, relocationMap, base);
+#endif
+}
+
+const char *relocation_backend()
+{
+#if LOADER_X86
+    return use_avx2() ? "avx2" : "sse2";
+#else
+    return "escalar";
+#endif
+}
+
+bool set_relocation_backend(string_view name)
+{
+#if LOADER_X86
+    if (name == "sse2" || (name == "avx2" && has_avx2()))
+    {
+        use_avx2() = name == "avx2";
+        return true;
+    }
+    return false;
+#else
+    return name == "escalar";
+#endif
+}
+
+vector<LoadedImage> load_images(const vector<ObjectImage> &images, vector<int> &memory, int firstBase)
+{
+    vector<LoadedImage> loaded;
+    size_t next = static_cast<size_t>(max(0, firstBase));
+    for (const ObjectImage &image : images)
+    {
+        int base = static_cast<int>(next);
+        if (image.hasUnresolved())
+            throw runtime_error("Objeto com pendencias nao resolvidas nao pode ser carregado.");
+        size_t end = next + image.words.size();
+        if (memory.size() < end)
+            memory.resize(end, 0);
+        copy(image.words.begin(), image.words.end(), memory.begin() + static_cast<ptrdiff_t>(next));
+        if (!image.relocationMap.empty())
+            relocate_words(memory.data() + next, image.words.size(), image.relocationMap.data(), base);
+        loaded.push_back({base, base + image.entryPoint});
+        next = end;
+    }
+    return loaded;
+}
@@ -0,0 +1,40 @@
+#ifndef LOADER_HPP
+#define LOADER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "ObjectFile.hpp"
+
+using namespace std;
+
+// Relocação vetorizada: com GCC/Clang em x86 usa AVX2 quando o processador tem
+// (detectado em tempo de execução) e SSE2 nos demais; fora de x86, ou com
+// -DLOADER_SCALAR, usa o laço escalar.
+
+// Soma `base` a cada words[i] cujo bit i está ligado em `relocationMap`
+// (bit i % 8 do byte i / 8). Cada byte do mapa vira uma máscara de 8 (AVX2) ou
+// 2×4 (SSE2) lanes e a soma é feita só nas lanes marcadas; blocos de 64 words
+// sem relocações são pulados. A soma é em 32 bits com complemento de dois.
+void relocate_words(int* words, size_t count, const uint8_t* relocationMap, int base);
+// Mesma operação, uma word por vez (referência e fallback).
+void relocate_words_scalar(int* words, size_t count, const uint8_t* relocationMap, int base);
+// Implementação usada por relocate_words: "avx2", "sse2" ou "escalar".
+const char* relocation_backend();
+// Troca a implementação de relocate_words, como set_text_scan_backend.
+bool set_relocation_backend(string_view name);
+
+// Posição de uma imagem carregada por load_images.
+struct LoadedImage {
+    int base;       // endereço da primeira word
+    int entryPoint; // ponto de entrada já relocado
+};
+
+// Coloca as imagens em `memory`, uma depois da outra a partir de `firstBase`
+// (a memória cresce conforme necessário; o que fica antes não é alterado), e
+// reloca cada uma com relocate_words. Lança runtime_error para imagens com
+// pendências.
+vector<LoadedImage> load_images(const vector<ObjectImage>& images, vector<int>& memory, int firstBase = 0);
+
+#endif // LOADER_HPP
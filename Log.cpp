@@ -0,0 +1,82 @@
+#include "Log.hpp"
+#include <stdexcept>
+
+using namespace std;
+
+bool parse_log_level(string_view name, LogLevel &level)
+{
+    if (name == "off")
+        level = LogLevel::OFF;
+    else if (name == "error")
+        level = LogLevel::ERROR;
+    else if (name == "info")
+        level = LogLevel::INFO;
+    else if (name == "trace")
+        level = LogLevel::TRACE;
+    else
+        return false;
+    return true;
+}
+
+TraceFile::TraceFile(const string &filename) : file(filename, ios::binary)
+{
+    if (!file.is_open())
+    {
+        throw runtime_error("Nao foi possivel abrir o arquivo de trace: " + filename);
+    }
+}
+
+void TraceFile::write(string_view text)
+{
+    lock_guard<mutex> guard(lock);
+    file.write(text.data(), text.size());
+    file.flush();
+}
+
+void Logger::write(LogLevel messageLevel, string_view message)
+{
+    lock_guard<mutex> guard(lock);
+    if (messageLevel == LogLevel::TRACE)
+    {
+        traceBuffer.append(message);
+        traceBuffer.push_back('\n');
+        if (traceBuffer.size() >= traceBufferLimit)
+            flush_trace();
+        return;
+    }
+    // Descarrega o trace antes para manter a ordem quando ambos vão para `out`.
+    if (!traceFile)
+        flush_trace();
+    out.write(message.data(), message.size());
+    out.put('\n');
+}
+
+void Logger::flush()
+{
+    lock_guard<mutex> guard(lock);
+    flush_trace();
+    out.flush();
+}
+
+void Logger::flush_trace()
+{
+    if (traceBuffer.empty())
+        return;
+    if (traceFile)
+        traceFile->write(traceBuffer);
+    else
+        out.write(traceBuffer.data(), traceBuffer.size());
+    traceBuffer.clear();
+}
+
+ostringstream &Logger::scratch()
+{
+    thread_local ostringstream stream;
+    return stream;
+}
+
+Logger &Logger::standard()
+{
+    static Logger logger(cout);
+    return logger;
+}
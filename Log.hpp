@@ -0,0 +1,90 @@
+#ifndef LOG_HPP
+#define LOG_HPP
+
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+// Níveis de log, do mais restrito ao mais detalhado.
+enum class LogLevel {
+    OFF,
+    ERROR,  // erros de montagem e erros fatais
+    INFO,   // etapas da compilação e arquivos gerados (padrão)
+    TRACE   // cada linha de macro, substituição e argumento aninhado
+};
+
+// Nível máximo compilado no binário. Com -DLOG_MAX_LEVEL=2 (INFO) as chamadas
+// LOG_TRACE viram código morto e somem do executável.
+#ifndef LOG_MAX_LEVEL
+#define LOG_MAX_LEVEL 3
+#endif
+
+// Converte "off", "error", "info" ou "trace". Retorna false se o nome for inválido.
+bool parse_log_level(string_view name, LogLevel& level);
+
+// Arquivo de trace compartilhado (--trace-file). No modo lote vários arquivos
+// escrevem nele; cada escrita é um bloco inteiro de linhas.
+class TraceFile {
+public:
+    explicit TraceFile(const string& filename);
+    void write(string_view text);
+
+private:
+    ofstream file;
+    mutex lock;
+};
+
+// Log de uma compilação. ERROR/INFO vão direto para `out`; TRACE é acumulado
+// num buffer e só é gravado (em `out` ou no TraceFile) quando o buffer enche,
+// numa mensagem de nível mais alto ou em flush(). Pode ser usado pelas duas
+// threads do pipeline ao mesmo tempo.
+class Logger {
+public:
+    explicit Logger(ostream& out, LogLevel level = LogLevel::INFO, TraceFile* traceFile = nullptr)
+        : out(out), level(level), traceFile(traceFile) {}
+    ~Logger() { flush(); }
+
+    bool enabled(LogLevel messageLevel) const { return messageLevel != LogLevel::OFF && messageLevel <= level; }
+    // Grava uma mensagem (uma linha, sem o '\n').
+    void write(LogLevel messageLevel, string_view message);
+    void flush();
+
+    // Stream reaproveitado (um por thread) para formatar as mensagens das macros LOG_*.
+    static ostringstream& scratch();
+    // Log padrão em cout, nível INFO.
+    static Logger& standard();
+
+private:
+    void flush_trace();
+
+    static constexpr size_t traceBufferLimit = 64 * 1024;
+
+    ostream& out;
+    LogLevel level;
+    TraceFile* traceFile;
+    string traceBuffer;
+    mutex lock;
+};
+
+// Formata e grava a mensagem só se o nível estiver ativo; com o nível acima de
+// LOG_MAX_LEVEL a condição é constante e o compilador remove a chamada.
+#define LOG_AT(logger, messageLevel, expr)                                                       \
+    do {                                                                                         \
+        if (static_cast<int>(messageLevel) <= LOG_MAX_LEVEL && (logger).enabled(messageLevel)) { \
+            ostringstream& log_stream_ = Logger::scratch();                                      \
+            log_stream_.str(string());                                                           \
+            log_stream_ << expr;                                                                 \
+            (logger).write(messageLevel, log_stream_.str());                                     \
+        }                                                                                        \
+    } while (0)
+
+#define LOG_ERROR(logger, expr) LOG_AT(logger, LogLevel::ERROR, expr)
+#define LOG_INFO(logger, expr) LOG_AT(logger, LogLevel::INFO, expr)
+#define LOG_TRACE(logger, expr) LOG_AT(logger, LogLevel::TRACE, expr)
+
+#endif // LOG_HPP
@@ -0,0 +1,73 @@
+#include "Memory.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+#ifdef MEMORY_COUNT_ALLOCATIONS
+namespace
+{
+    // Tipo trivial: inicializado sem código, vale desde o início da thread
+    // (inclusive dentro do próprio operator new).
+    thread_local AllocationCount threadCount;
+    atomic<size_t> processBytes{0};
+    atomic<size_t> processCount{0};
+}
+
+void *operator new(size_t size)
+{
+    threadCount.bytes += size;
+    threadCount.count++;
+    processBytes.fetch_add(size, memory_order_relaxed);
+    processCount.fetch_add(1, memory_order_relaxed);
+    if (void *p = malloc(size == 0 ? 1 : size))
+        return p;
+    throw bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+AllocationCount thread_allocations()
+{
+    return threadCount;
+}
+
+AllocationCount process_allocations()
+{
+    return {processBytes.load(memory_order_relaxed), processCount.load(memory_order_relaxed)};
+}
+#endif
+
+Arena::Arena(size_t initialBytes) : block(new byte[initialBytes]), blockSize(initialBytes)
+{
+    monotonic.emplace(block.get(), blockSize, pmr::new_delete_resource());
+}
+
+void Arena::reset()
+{
+    if (usedBytes > blockSize)
+    {
+        // A folga cobre o alinhamento, que não entra em usedBytes.
+        size_t needed = usedBytes + usedBytes / 8;
+        blockSize = (needed + 4095) / 4096 * 4096;
+        monotonic.reset();
+        block.reset(new byte[blockSize]);
+    }
+    monotonic.emplace(block.get(), blockSize, pmr::new_delete_resource());
+    usedBytes = 0;
+}
+
+void *Arena::do_allocate(size_t bytes, size_t alignment)
+{
+    usedBytes += bytes;
+    return monotonic->allocate(bytes, alignment);
+}
@@ -0,0 +1,87 @@
+#ifndef MEMORY_HPP
+#define MEMORY_HPP
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+using namespace std;
+
+// Alocações feitas no heap (operator new). Compilado com
+// -DMEMORY_COUNT_ALLOCATIONS (o benchmark, ou um `compiler` para medir com
+// --stats), Memory.cpp substitui o operator new global do programa para contar
+// cada alocação na thread que a fez e no processo inteiro; os contadores só
+// crescem. Sem a macro o alocador padrão fica intocado e os contadores ficam
+// em zero. A macro vale para o programa inteiro (todos os arquivos).
+#ifdef MEMORY_COUNT_ALLOCATIONS
+inline constexpr bool allocation_counting = true;
+#else
+inline constexpr bool allocation_counting = false;
+#endif
+
+struct AllocationCount {
+    size_t bytes = 0;
+    size_t count = 0;
+
+    AllocationCount operator-(const AllocationCount& other) const
+    {
+        return {bytes - other.bytes, count - other.count};
+    }
+    AllocationCount& operator+=(const AllocationCount& other)
+    {
+        bytes += other.bytes;
+        count += other.count;
+        return *this;
+    }
+};
+
+#ifdef MEMORY_COUNT_ALLOCATIONS
+// Alocações da thread atual desde que ela começou.
+AllocationCount thread_allocations();
+// Alocações de todas as threads desde o início do processo.
+AllocationCount process_allocations();
+#else
+inline AllocationCount thread_allocations() { return {}; }
+inline AllocationCount process_allocations() { return {}; }
+#endif
+
+// Arena monotônica de uma execução: as alocações avançam um ponteiro num
+// bloco e a liberação individual não faz nada; reset() descarta tudo de uma
+// vez. O bloco é mantido entre execuções e, se uma execução passou dele (os
+// blocos extras vêm do heap), cresce no reset() para caber o que ela usou:
+// a partir daí a mesma carga não vai mais ao heap. Não é thread-safe: cada
+// estágio (thread) tem a sua.
+class Arena : public pmr::memory_resource {
+public:
+    explicit Arena(size_t initialBytes = 16 * 1024);
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // Os containers que usam a arena precisam ter soltado a memória antes
+    // (trocados por containers vazios).
+    void reset();
+    // Bytes entregues desde o último reset().
+    size_t used() const { return usedBytes; }
+    size_t capacity() const { return blockSize; }
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void*, size_t, size_t) override {}
+    bool do_is_equal(const pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    unique_ptr<byte[]> block;
+    size_t blockSize;
+    size_t usedBytes = 0;
+    optional<pmr::monotonic_buffer_resource> monotonic;
+};
+
+// Troca `container` por um vazio na mesma arena, soltando o que ele ocupava
+// (necessário antes de Arena::reset()).
+template <typename Container>
+void discard(Container& container, pmr::memory_resource* resource)
+{
+    Container(resource).swap(container);
+}
+
+#endif // MEMORY_HPP
@@ -0,0 +1,42 @@
+#include "MemoryAssembler.hpp"
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+
+MemoryAssembler::MemoryAssembler(MacroLimits limits)
+    : logger(cout, LogLevel::OFF), preprocessor(logger, limits), assembler(logger), sink(assembler)
+{
+    assembler.set_folded_input(true);
+}
+
+void MemoryAssembler::reset()
+{
+    preprocessor.reset();
+    assembler.reset();
+    output.words.clear();
+    output.wordsO1.clear();
+    output.errors.clear();
+    output.fatal.clear();
+}
+
+const AssemblyOutput &MemoryAssembler::assemble(string_view source)
+{
+    reset();
+    try
+    {
+        preprocessor.process_text(source, sink);
+        assembler.finish();
+    }
+    catch (const exception &e)
+    {
+        // Mesmo tratamento do compile_file: a montagem é abandonada.
+        output.fatal = e.what();
+        return output;
+    }
+    const vector<int> &code = assembler.object_code();
+    output.words.assign(code.begin(), code.end());
+    assembler.object_code_o1(output.wordsO1);
+    output.errors.assign(assembler.getErrors().begin(), assembler.getErrors().end());
+    return output;
+}
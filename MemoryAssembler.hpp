@@ -0,0 +1,62 @@
+#ifndef MEMORY_ASSEMBLER_HPP
+#define MEMORY_ASSEMBLER_HPP
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "Assembler.hpp"
+#include "LineStream.hpp"
+#include "Log.hpp"
+#include "Preprocessor.hpp"
+
+using namespace std;
+
+// Resultado de MemoryAssembler::assemble.
+struct AssemblyOutput {
+    vector<int> words;                // código resolvido (.o2)
+    vector<int> wordsO1;              // código com as pendências (.o1)
+    vector<pair<int, string>> errors; // (linha, mensagem) do montador
+    string fatal;                     // erro fatal (ex: limite de macros); vazio se não houve
+
+    bool ok() const { return fatal.empty() && errors.empty(); }
+};
+
+// API de biblioteca: pré-processa e monta um fonte em memória, sem arquivos.
+// As linhas expandidas vão direto do Preprocessor para o Assembler (sem fila
+// nem cópia) e a mesma instância é reaproveitada entre chamadas: reset()
+// limpa o estado mas mantém a capacidade de tabelas e buffers, então montar
+// muitos trechos pequenos em sequência não aloca depois que as estruturas
+// atingem o tamanho máximo. Uma instância por thread.
+class MemoryAssembler {
+public:
+    explicit MemoryAssembler(MacroLimits limits = {});
+    MemoryAssembler(const MemoryAssembler&) = delete;
+    MemoryAssembler& operator=(const MemoryAssembler&) = delete;
+
+    // Monta `source`. A referência devolvida vale até a próxima chamada.
+    const AssemblyOutput& assemble(string_view source);
+    // Limpa o estado (assemble() já chama no início).
+    void reset();
+    // Aplica o otimizador peephole (-O) nas próximas montagens.
+    void set_optimize(bool enabled) { assembler.set_optimize(enabled); }
+
+private:
+    // Entrega cada linha do pré-processador ao montador.
+    class FeedSink : public LineSink {
+    public:
+        explicit FeedSink(Assembler& assembler) : assembler(assembler) {}
+        void write(string_view line) override { assembler.feed(line); }
+
+    private:
+        Assembler& assembler;
+    };
+
+    Logger logger;
+    Preprocessor preprocessor;
+    Assembler assembler;
+    FeedSink sink;
+    AssemblyOutput output;
+};
+
+#endif // MEMORY_ASSEMBLER_HPP
@@ -0,0 +1,284 @@
+#include "ObjectFile.hpp"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+using namespace std;
+
+namespace
+{
+    void put_u16(string &out, uint16_t value)
+    {
+        out.push_back(static_cast<char>(value & 0xFF));
+        out.push_back(static_cast<char>(value >> 8));
+    }
+
+    void put_u32(string &out, uint32_t value)
+    {
+        for (int i = 0; i < 4; i++)
+            out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+
+    void put_varint(string &out, uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+    void put_signed(string &out, int64_t value)
+    {
+        put_varint(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+    }
+
+    // Leitura sequencial com checagem de limites.
+    class Reader
+    {
+    public:
+        explicit Reader(const string &data) : data(data) {}
+
+        const char *take(size_t n)
+        {
+            if (data.size() - pos < n)
+                throw runtime_error("Arquivo objeto truncado.");
+            const char *p = data.data() + pos;
+            pos += n;
+            return p;
+        }
+
+        uint16_t u16()
+        {
+            const unsigned char *p = reinterpret_cast<const unsigned char *>(take(2));
+            return static_cast<uint16_t>(p[0] | (p[1] << 8));
+        }
+
+        uint32_t u32()
+        {
+            const unsigned char *p = reinterpret_cast<const unsigned char *>(take(4));
+            return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+                   (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+        }
+
+        uint64_t varint()
+        {
+            uint64_t value = 0;
+            for (int shift = 0; shift < 64; shift += 7)
+            {
+                unsigned char byte = static_cast<unsigned char>(*take(1));
+                value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                if (!(byte & 0x80))
+                    return value;
+            }
+            throw runtime_error("Varint invalido no arquivo objeto.");
+        }
+
+        int64_t signed_varint()
+        {
+            uint64_t raw = varint();
+            return static_cast<int64_t>(raw >> 1) ^ -static_cast<int64_t>(raw & 1);
+        }
+
+        // Confere um número de elementos lido do arquivo antes de alocar para
+        // ele: cada elemento ocupa pelo menos `minBytes`, então um contador
+        // maior que o que resta no arquivo só pode vir de um objeto corrompido.
+        size_t count(uint64_t value, size_t minBytes)
+        {
+            if (value > (data.size() - pos) / minBytes)
+                throw runtime_error("Arquivo objeto truncado.");
+            return static_cast<size_t>(value);
+        }
+
+    private:
+        const string &data;
+        size_t pos = 0;
+    };
+}
+
+void write_binary_object(const string &filename, const ObjectImage &image)
+{
+    string out;
+    out.reserve(16 + image.words.size() * 2);
+    uint16_t flags = 0;
+    if (image.hasUnresolved())
+        flags |= object_format::FLAG_UNRESOLVED | object_format::FLAG_PENDING;
+    if (!image.definitions.empty())
+        flags |= object_format::FLAG_DEFINITIONS;
+    bool hasRelocations = any_of(image.relocationMap.begin(), image.relocationMap.end(), [](uint8_t byte)
+                                 { return byte != 0; });
+    if (hasRelocations)
+        flags |= object_format::FLAG_RELOCATIONS;
+
+    out.append(object_format::MAGIC, sizeof(object_format::MAGIC));
+    put_u16(out, object_format::VERSION);
+    put_u16(out, flags);
+    put_u32(out, static_cast<uint32_t>(image.words.size()));
+    put_u32(out, static_cast<uint32_t>(image.entryPoint));
+    for (int word : image.words)
+        put_signed(out, word);
+
+    if (flags & object_format::FLAG_PENDING)
+    {
+        put_varint(out, image.pending.size());
+        for (const PendingChain &chain : image.pending)
+        {
+            put_varint(out, chain.symbol.size());
+            out.append(chain.symbol);
+            put_varint(out, chain.sites.size());
+            for (const FixupSite &site : chain.sites)
+            {
+                put_varint(out, static_cast<uint64_t>(site.slot));
+                put_signed(out, site.offset);
+            }
+        }
+    }
+    if (flags & object_format::FLAG_DEFINITIONS)
+    {
+        put_varint(out, image.definitions.size());
+        for (const SymbolDefinition &definition : image.definitions)
+        {
+            put_varint(out, definition.symbol.size());
+            out.append(definition.symbol);
+            put_varint(out, static_cast<uint64_t>(definition.address));
+        }
+    }
+    if (flags & object_format::FLAG_RELOCATIONS)
+    {
+        size_t mapBytes = (image.words.size() + 7) / 8;
+        size_t stored = min(mapBytes, image.relocationMap.size());
+        out.append(reinterpret_cast<const char *>(image.relocationMap.data()), stored);
+        out.append(mapBytes - stored, '\0');
+    }
+
+    ofstream file(filename, ios::binary);
+    if (!file.is_open())
+    {
+        throw runtime_error("Erro ao abrir o arquivo objeto binario: " + filename);
+    }
+    file.write(out.data(), static_cast<streamsize>(out.size()));
+    file.close();
+    if (!file)
+    {
+        throw runtime_error("Erro ao gravar o arquivo objeto binario: " + filename);
+    }
+}
+
+ObjectImage read_binary_object(const string &filename)
+{
+    ifstream file(filename, ios::binary);
+    if (!file.is_open())
+    {
+        throw runtime_error("Erro ao abrir o arquivo objeto binario: " + filename);
+    }
+    string data((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+    Reader in(data);
+
+    if (memcmp(in.take(4), object_format::MAGIC, 4) != 0)
+        throw runtime_error("Arquivo nao e um objeto binario: " + filename);
+    uint16_t version = in.u16();
+    if (version != object_format::VERSION)
+        throw runtime_error("Versao de objeto binario nao suportada: " + to_string(version));
+    uint16_t flags = in.u16();
+
+    ObjectImage image;
+    uint32_t wordCount = in.u32();
+    image.entryPoint = static_cast<int>(in.u32());
+    // Tamanhos mínimos: word = 1 byte; cadeia, nó e definição = 2 varints.
+    image.words.resize(in.count(wordCount, 1));
+    for (uint32_t i = 0; i < wordCount; i++)
+        image.words[i] = static_cast<int>(in.signed_varint());
+
+    if (flags & object_format::FLAG_PENDING)
+    {
+        image.pending.resize(in.count(in.varint(), 2));
+        for (PendingChain &chain : image.pending)
+        {
+            size_t length = in.varint();
+            chain.symbol.assign(in.take(length), length);
+            chain.sites.resize(in.count(in.varint(), 2));
+            for (FixupSite &site : chain.sites)
+            {
+                site.slot = static_cast<int>(in.varint());
+                site.offset = static_cast<int>(in.signed_varint());
+                if (site.slot < 0 || static_cast<uint32_t>(site.slot) >= wordCount)
+                    throw runtime_error("Pendencia fora do codigo no objeto binario.");
+            }
+        }
+    }
+    if (flags & object_format::FLAG_DEFINITIONS)
+    {
+        image.definitions.resize(in.count(in.varint(), 2));
+        for (SymbolDefinition &definition : image.definitions)
+        {
+            size_t length = in.varint();
+            definition.symbol.assign(in.take(length), length);
+            definition.address = static_cast<int>(in.varint());
+        }
+    }
+    if (flags & object_format::FLAG_RELOCATIONS)
+    {
+        size_t mapBytes = (wordCount + 7) / 8;
+        const uint8_t *map = reinterpret_cast<const uint8_t *>(in.take(mapBytes));
+        image.relocationMap.assign(map, map + mapBytes);
+    }
+    return image;
+}
+
+void write_text_object(ostream &file, const vector<int> &words)
+{
+    write_text_object(file, words, {});
+}
+
+void write_text_object(ostream &file, const vector<int> &words, const vector<Backpatch> &patches)
+{
+    size_t nextPatch = 0;
+    // Até 11 caracteres por int de 32 bits + separador.
+    string out(words.size() * 12, '\0');
+    char *cur = out.data();
+    char *end = out.data() + out.size();
+    for (size_t i = 0; i < words.size(); i++)
+    {
+        if (i > 0)
+            *cur++ = ' ';
+        int word = words[i];
+        if (nextPatch < patches.size() && static_cast<size_t>(patches[nextPatch].slot) == i)
+            word = patches[nextPatch++].original;
+        cur = to_chars(cur, end, word).ptr;
+    }
+    out.resize(static_cast<size_t>(cur - out.data()));
+    file.write(out.data(), static_cast<streamsize>(out.size()));
+}
+
+vector<int> read_text_object(const string &filename)
+{
+    ifstream file(filename, ios::binary);
+    if (!file.is_open())
+    {
+        throw runtime_error("Erro ao abrir o arquivo objeto: " + filename);
+    }
+    string data((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+
+    vector<int> words;
+    const char *cur = data.data();
+    const char *end = data.data() + data.size();
+    while (true)
+    {
+        while (cur < end && isspace(static_cast<unsigned char>(*cur)))
+            cur++;
+        if (cur == end)
+            break;
+        int word = 0;
+        auto result = from_chars(cur, end, word);
+        if (result.ec != errc())
+            throw runtime_error("Word invalida no arquivo objeto: " + filename);
+        words.push_back(word);
+        cur = result.ptr;
+    }
+    return words;
+}
@@ -0,0 +1,89 @@
+#ifndef OBJECT_FILE_HPP
+#define OBJECT_FILE_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Pendência ainda não resolvida: posição no código e offset de LABEL+offset.
+struct FixupSite {
+    int slot;
+    int offset;
+};
+
+// Lista de pendências de um símbolo não definido, na ordem da lista encadeada
+// do .o1 (da cabeça até o último nó).
+struct PendingChain {
+    string symbol;
+    vector<FixupSite> sites;
+};
+
+// Correção aplicada a uma posição do código: guarda o valor que estava lá antes
+// (o placeholder da lista de pendências), para reconstruir o .o1.
+struct Backpatch {
+    int slot;
+    int original;
+};
+
+// Símbolo exportado (PUBLIC) e o seu endereço no módulo.
+struct SymbolDefinition {
+    string symbol;
+    int address;
+};
+
+// Imagem de objeto em memória (conteúdo do .o2 mais metadados). Num módulo,
+// `pending` é a tabela de uso (as cadeias do .o1 dos símbolos EXTERN) e
+// `definitions` a tabela de definições. O mapa de relocação tem um bit por
+// word (bit i % 8 do byte i / 8): ligado se a word guarda um endereço de
+// rótulo (LABEL ou LABEL+offset), relativo ao início da imagem.
+struct ObjectImage {
+    vector<int> words;
+    int entryPoint = 0;
+    vector<PendingChain> pending;
+    vector<SymbolDefinition> definitions;
+    vector<uint8_t> relocationMap; // (words + 7) / 8 bytes, ou vazio: nenhuma relocação
+
+    bool hasUnresolved() const { return !pending.empty(); }
+    bool isRelocated(size_t slot) const
+    {
+        return slot / 8 < relocationMap.size() && ((relocationMap[slot / 8] >> (slot % 8)) & 1) != 0;
+    }
+    void markRelocated(size_t slot)
+    {
+        relocationMap.resize((words.size() + 7) / 8, 0);
+        relocationMap[slot / 8] |= static_cast<uint8_t>(1u << (slot % 8));
+    }
+};
+
+// Formato binário (.obj), todos os inteiros em little-endian:
+//   magic "SBOB" | version u16 | flags u16 | wordCount u32 | entryPoint u32
+//   words: wordCount varints (zigzag, pois a lista de pendências usa -1)
+//   se FLAG_PENDING: nº de cadeias (varint) e, para cada uma, tamanho do nome,
+//   bytes do nome, nº de nós e pares (slot, offset) em varint.
+//   se FLAG_DEFINITIONS: nº de definições e, para cada uma, tamanho
+//   do nome, bytes do nome e endereço (varint).
+//   se FLAG_RELOCATIONS: o mapa de relocação, (wordCount + 7) / 8 bytes.
+namespace object_format {
+    inline constexpr char MAGIC[4] = {'S', 'B', 'O', 'B'};
+    inline constexpr uint16_t VERSION = 3;
+    inline constexpr uint16_t FLAG_UNRESOLVED = 1 << 0;
+    inline constexpr uint16_t FLAG_PENDING = 1 << 1;
+    inline constexpr uint16_t FLAG_DEFINITIONS = 1 << 2;
+    inline constexpr uint16_t FLAG_RELOCATIONS = 1 << 3;
+}
+
+void write_binary_object(const string& filename, const ObjectImage& image);
+ObjectImage read_binary_object(const string& filename);
+
+// Formato texto do .o1/.o2: words em decimal separados por um espaço. O texto é
+// montado com to_chars num único buffer e gravado de uma vez.
+void write_text_object(ostream& out, const vector<int>& words);
+// Idem, mas grava `original` nas posições de `patches` (ordenado por slot).
+void write_text_object(ostream& out, const vector<int>& words, const vector<Backpatch>& patches);
+// Lê um .o1/.o2 (words em decimal separados por espaço).
+vector<int> read_text_object(const string& filename);
+
+#endif // OBJECT_FILE_HPP
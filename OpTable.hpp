@@ -0,0 +1,106 @@
+#ifndef OP_TABLE_HPP
+#define OP_TABLE_HPP
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+using namespace std;
+
+enum class OpKind {
+    INSTRUCTION,
+    DIRECTIVE
+};
+
+struct OpInfo {
+    string_view name;
+    OpKind kind;
+    int opcode;
+    int size;           // Tamanho em words de memória.
+    int numParameters;
+};
+
+// Tabela única de operações (ISA + diretivas), usada pelo léxico e pelo montador.
+// Para adicionar um opcode basta acrescentar uma linha aqui: o hash perfeito
+// abaixo é recalculado em tempo de compilação.
+// Diretivas: SPACE ocupa 1 word por padrão (ou N com argumento) e aceita até
+// 1 parâmetro; CONST ocupa 1 word e exige 1 parâmetro; PUBLIC e EXTERN não
+// ocupam memória e exigem 1 rótulo.
+inline constexpr OpInfo OPTAB[] = {
+    {"ADD", OpKind::INSTRUCTION, 1, 2, 1},
+    {"SUB", OpKind::INSTRUCTION, 2, 2, 1},
+    {"MULT", OpKind::INSTRUCTION, 3, 2, 1},
+    {"DIV", OpKind::INSTRUCTION, 4, 2, 1},
+    {"JMP", OpKind::INSTRUCTION, 5, 2, 1},
+    {"JMPN", OpKind::INSTRUCTION, 6, 2, 1},
+    {"JMPP", OpKind::INSTRUCTION, 7, 2, 1},
+    {"JMPZ", OpKind::INSTRUCTION, 8, 2, 1},
+    {"COPY", OpKind::INSTRUCTION, 9, 3, 2},
+    {"LOAD", OpKind::INSTRUCTION, 10, 2, 1},
+    {"STORE", OpKind::INSTRUCTION, 11, 2, 1},
+    {"INPUT", OpKind::INSTRUCTION, 12, 2, 1},
+    {"OUTPUT", OpKind::INSTRUCTION, 13, 2, 1},
+    {"STOP", OpKind::INSTRUCTION, 14, 1, 0},
+    {"SPACE", OpKind::DIRECTIVE, 0, 1, 1},
+    {"CONST", OpKind::DIRECTIVE, 0, 1, 1},
+    {"PUBLIC", OpKind::DIRECTIVE, 0, 0, 1},
+    {"EXTERN", OpKind::DIRECTIVE, 0, 0, 1},
+};
+
+namespace optab_detail {
+    inline constexpr size_t COUNT = sizeof(OPTAB) / sizeof(OPTAB[0]);
+    inline constexpr size_t SLOTS = 64; // potência de 2, > COUNT
+    static_assert((SLOTS & (SLOTS - 1)) == 0 && SLOTS > COUNT, "SLOTS deve ser potencia de 2 maior que a tabela");
+
+    // FNV-1a com base variável (seed).
+    constexpr uint32_t hash(string_view s, uint32_t seed) {
+        uint32_t h = seed;
+        for (char c : s) {
+            h ^= static_cast<unsigned char>(c);
+            h *= 16777619u;
+        }
+        return h;
+    }
+
+    constexpr bool seed_is_perfect(uint32_t seed) {
+        bool used[SLOTS] = {};
+        for (size_t i = 0; i < COUNT; i++) {
+            size_t slot = hash(OPTAB[i].name, seed) & (SLOTS - 1);
+            if (used[slot]) return false;
+            used[slot] = true;
+        }
+        return true;
+    }
+
+    // Procura, em tempo de compilação, uma seed sem colisões.
+    constexpr uint32_t find_seed() {
+        for (uint32_t seed = 2166136261u; seed != 2166136261u + 100000u; seed++) {
+            if (seed_is_perfect(seed)) return seed;
+        }
+        return 0;
+    }
+
+    inline constexpr uint32_t SEED = find_seed();
+    static_assert(SEED != 0, "Nenhuma seed de hash perfeito encontrada; aumente SLOTS");
+
+    constexpr array<int8_t, SLOTS> build_slots() {
+        array<int8_t, SLOTS> slots{};
+        for (size_t i = 0; i < SLOTS; i++) slots[i] = -1;
+        for (size_t i = 0; i < COUNT; i++) {
+            slots[hash(OPTAB[i].name, SEED) & (SLOTS - 1)] = static_cast<int8_t>(i);
+        }
+        return slots;
+    }
+
+    inline constexpr array<int8_t, SLOTS> SLOT_INDEX = build_slots();
+}
+
+// Uma sondagem no hash perfeito + uma comparação. Retorna nullptr se a
+// palavra não for instrução nem diretiva.
+constexpr const OpInfo* find_op(string_view word) {
+    int8_t index = optab_detail::SLOT_INDEX[optab_detail::hash(word, optab_detail::SEED) & (optab_detail::SLOTS - 1)];
+    if (index < 0 || OPTAB[index].name != word) return nullptr;
+    return &OPTAB[index];
+}
+
+#endif // OP_TABLE_HPP
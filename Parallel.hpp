@@ -0,0 +1,59 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Executa body(0..count-1) em até `jobs` threads. Cada thread pega o próximo
+// índice livre; a primeira exceção lançada é repassada a quem chamou.
+inline void parallel_for(size_t count, unsigned jobs, const function<void(size_t)>& body)
+{
+    jobs = static_cast<unsigned>(max<size_t>(1, min<size_t>(jobs, count)));
+    if (jobs == 1)
+    {
+        for (size_t i = 0; i < count; i++)
+            body(i);
+        return;
+    }
+
+    atomic<size_t> next{0};
+    exception_ptr error;
+    mutex errorLock;
+    auto worker = [&]
+    {
+        while (true)
+        {
+            size_t i = next.fetch_add(1);
+            if (i >= count)
+                break;
+            try
+            {
+                body(i);
+            }
+            catch (...)
+            {
+                lock_guard<mutex> guard(errorLock);
+                if (!error)
+                    error = current_exception();
+            }
+        }
+    };
+
+    vector<thread> pool;
+    for (unsigned t = 0; t < jobs; t++)
+        pool.emplace_back(worker);
+    for (thread& t : pool)
+        t.join();
+    if (error)
+        rethrow_exception(error);
+}
+
+#endif // PARALLEL_HPP
@@ -0,0 +1,182 @@
+#include "Peephole.hpp"
+
+using namespace std;
+
+namespace
+{
+    constexpr int OP_JMP = 5;
+    constexpr int OP_COPY = 9;
+    constexpr int OP_LOAD = 10;
+    constexpr int OP_STORE = 11;
+    // Limite de saltos seguidos ao encurtar uma cadeia (evita laços JMP A / A: JMP A).
+    constexpr int MAX_THREAD_HOPS = 64;
+
+    bool is_jump(int opcode)
+    {
+        return opcode >= 5 && opcode <= 8;
+    }
+}
+
+PeepholeReport optimize_peephole(PeepholeProgram &program)
+{
+    PeepholeReport report;
+    vector<int> &words = program.words;
+    vector<CodeItem> &items = program.items;
+    vector<SymbolRef> &refs = program.refs;
+    const int size = static_cast<int>(words.size());
+
+    if (program.hasImmediate)
+    {
+        report.skipped = "operando numerico absoluto";
+        return report;
+    }
+
+    // Índices por posição: item que começa / que contém cada word e referência em cada slot.
+    vector<int> itemAt(size + 1, -1);
+    vector<int> owner(size, -1);
+    for (size_t k = 0; k < items.size(); k++)
+    {
+        itemAt[items[k].start] = static_cast<int>(k);
+        for (int w = items[k].start; w < items[k].start + items[k].size; w++)
+            owner[w] = static_cast<int>(k);
+    }
+    vector<int> refAt(size, -1);
+    for (size_t r = 0; r < refs.size(); r++)
+        refAt[refs[r].slot] = static_cast<int>(r);
+    auto target = [&](const SymbolRef &ref)
+    { return program.symbolAddress[ref.symbol] + ref.offset; };
+
+    // Só otimiza programas com código e dados separados: saltos caem no início
+    // de instruções (ou no fim do programa) e os demais operandos apontam para dados.
+    for (const SymbolRef &ref : refs)
+    {
+        int t = target(ref);
+        if (is_jump(items[owner[ref.slot]].opcode))
+        {
+            if (t < 0 || t > size || (t < size && (itemAt[t] < 0 || items[itemAt[t]].opcode == 0)))
+            {
+                report.skipped = "salto para fora do inicio de uma instrucao";
+                return report;
+            }
+        }
+        else if (t < 0 || t >= size || items[owner[t]].opcode != 0)
+        {
+            report.skipped = "acesso a memoria de codigo";
+            return report;
+        }
+    }
+
+    // Encurta cadeias de saltos: o destino passa a ser o do último JMP da cadeia.
+    for (const CodeItem &item : items)
+    {
+        if (!is_jump(item.opcode))
+            continue;
+        SymbolRef &ref = refs[refAt[item.start + 1]];
+        int last = -1;
+        int t = target(ref);
+        for (int hops = 0; hops < MAX_THREAD_HOPS && t < size && items[itemAt[t]].opcode == OP_JMP; hops++)
+        {
+            int next = refAt[t + 1];
+            if (target(refs[next]) == t)
+                break;
+            last = next;
+            t = target(refs[next]);
+        }
+        if (last >= 0 && (refs[last].symbol != ref.symbol || refs[last].offset != ref.offset))
+        {
+            ref.symbol = refs[last].symbol;
+            ref.offset = refs[last].offset;
+            report.threadedJumps++;
+        }
+    }
+
+    vector<char> targeted(items.size(), 0);
+    for (const SymbolRef &ref : refs)
+    {
+        int t = target(ref);
+        if (is_jump(items[owner[ref.slot]].opcode) && t < size)
+            targeted[itemAt[t]] = 1;
+    }
+
+    vector<char> removed(items.size(), 0);
+    for (size_t k = 0; k < items.size(); k++)
+    {
+        const CodeItem &item = items[k];
+        if (is_jump(item.opcode) && !targeted[k] && target(refs[refAt[item.start + 1]]) == item.start + item.size)
+        {
+            removed[k] = 1; // salto para a instrução seguinte
+            continue;
+        }
+        if (k + 1 >= items.size())
+            continue;
+        const CodeItem &next = items[k + 1];
+        if (item.opcode == OP_STORE && next.opcode == OP_LOAD && !targeted[k + 1] &&
+            words[item.start + 1] == words[next.start + 1])
+        {
+            removed[k + 1] = 1; // o ACC já tem o valor de X
+        }
+        else if (item.opcode == OP_COPY && next.opcode == OP_COPY && !targeted[k] &&
+                 words[item.start + 2] == words[next.start + 2] && words[next.start + 1] != words[next.start + 2])
+        {
+            removed[k] = 1; // X é sobrescrito antes de ser lido
+        }
+    }
+
+    // Novo endereço de cada word; as removidas ficam com o endereço da próxima mantida.
+    vector<int> newAddress(size + 1);
+    int next = 0;
+    for (int w = 0; w <= size; w++)
+    {
+        newAddress[w] = next;
+        if (w < size && !removed[owner[w]])
+            next++;
+    }
+    // LABEL+offset precisa continuar valendo endereço(LABEL) + offset.
+    for (const SymbolRef &ref : refs)
+    {
+        if (removed[owner[ref.slot]])
+            continue;
+        int base = program.symbolAddress[ref.symbol];
+        if (newAddress[base] + ref.offset != newAddress[base + ref.offset])
+        {
+            report = PeepholeReport();
+            report.skipped = "LABEL+offset atravessa codigo removido";
+            return report;
+        }
+    }
+
+    vector<int> newWords;
+    newWords.reserve(next);
+    vector<CodeItem> newItems;
+    for (size_t k = 0; k < items.size(); k++)
+    {
+        if (removed[k])
+        {
+            report.removedInstructions++;
+            report.removedWords += items[k].size;
+            continue;
+        }
+        newItems.push_back({newAddress[items[k].start], items[k].opcode, items[k].size});
+        newWords.insert(newWords.end(), words.begin() + items[k].start, words.begin() + items[k].start + items[k].size);
+    }
+    for (int &address : program.symbolAddress)
+        address = newAddress[address];
+    vector<SymbolRef> newRefs;
+    for (const SymbolRef &ref : refs)
+    {
+        if (removed[owner[ref.slot]])
+            continue;
+        // Na passagem única a referência é adiante se o símbolo fica depois da
+        // instrução que a contém; o salto encurtado pode ter mudado isso.
+        int site = newAddress[items[owner[ref.slot]].start];
+        int address = program.symbolAddress[ref.symbol];
+        newRefs.push_back({newAddress[ref.slot], ref.symbol, ref.offset, address > site});
+        newWords[newRefs.back().slot] = address + ref.offset;
+    }
+
+    words = std::move(newWords);
+    items = std::move(newItems);
+    refs = std::move(newRefs);
+    report.applied = report.removedInstructions > 0 || report.threadedJumps > 0;
+    return report;
+}
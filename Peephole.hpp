@@ -0,0 +1,54 @@
+#ifndef PEEPHOLE_HPP
+#define PEEPHOLE_HPP
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Item do código montado, na ordem do programa: uma instrução ou um bloco de
+// dados (SPACE/CONST, com opcode 0).
+struct CodeItem {
+    int start;  // posição no código
+    int opcode; // 0 = dados
+    int size;   // words
+};
+
+// Operando que referencia um símbolo (LABEL ou LABEL+offset).
+struct SymbolRef {
+    int slot;      // posição do operando no código
+    int symbol;    // ID na SymbolTable
+    int offset;
+    bool forward;  // o símbolo ainda não estava definido (vai para a lista do .o1);
+                   // recalculado pelo otimizador
+};
+
+// Programa montado visto como instruções, alterado no lugar pelo otimizador.
+struct PeepholeProgram {
+    vector<int> words;
+    vector<CodeItem> items;
+    vector<SymbolRef> refs;        // em ordem de slot
+    vector<int> symbolAddress;     // endereço de cada símbolo (todos definidos)
+    bool hasImmediate = false;     // algum operando numérico absoluto
+};
+
+struct PeepholeReport {
+    bool applied = false;
+    string skipped;                // motivo quando não foi aplicado
+    int removedInstructions = 0;
+    int removedWords = 0;
+    int threadedJumps = 0;
+};
+
+// Reescritas locais seguras sobre o programa:
+//  - saltos para um JMP passam a ir direto para o destino final;
+//  - STORE X seguido de LOAD X: o LOAD é removido;
+//  - COPY A, X seguido de COPY B, X (com B != X): o primeiro COPY é removido;
+//  - salto para a instrução seguinte é removido.
+// Uma instrução só é removida se nenhum salto chega nela. Os endereços dos
+// rótulos, os operandos e as referências são remapeados juntos. Se o programa
+// usa endereços absolutos, lê/escreve a área de código ou salta para fora do
+// início de uma instrução, nada é alterado e `skipped` explica o motivo.
+PeepholeReport optimize_peephole(PeepholeProgram& program);
+
+#endif // PEEPHOLE_HPP
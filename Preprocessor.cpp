@@ -1,184 +1,493 @@
 #include "Preprocessor.hpp"
+#include "TextScan.hpp"
 #include <fstream>
-#include <sstream>
-#include <iostream>
 #include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <stdexcept>
 
 using namespace std;
 
-vector<string> Preprocessor::split(const string &s)
+size_t Preprocessor::split(string_view s, pmr::vector<pmr::string> &tokens)
 {
-    vector<string> tokens;
-    string token;
-    istringstream tokenStream(s);
-
     // Divide por espaços e vírgulas, removendo vírgulas do final dos tokens.
-    while (tokenStream >> token)
+    // Os tokens são escritos sobre as strings da linha anterior; as que
+    // sobram não são destruídas, para manter os buffers.
+    size_t count = 0;
+    size_t i = 0;
+    while (i < s.size())
+    {
+        while (i < s.size() && isspace(static_cast<unsigned char>(s[i])))
+            i++;
+        size_t start = i;
+        while (i < s.size() && !isspace(static_cast<unsigned char>(s[i])))
+            i++;
+        size_t end = i;
+        if (end > start && s[end - 1] == ',')
+            end--;
+        if (end == start)
+            continue;
+        if (count == tokens.size())
+            tokens.emplace_back();
+        tokens[count++].assign(s.substr(start, end - start));
+    }
+    return count;
+}
+
+// Compila uma linha do corpo (já com #1, #2...) em pedaços literais e de
+// parâmetro, marcando os tokens separados por espaço como faria split().
+MacroLine Preprocessor::compile_macro_line(string_view text)
+{
+    MacroLine line(&arena);
+    line.text.assign(text);
+    const pmr::string &t = line.text;
+    size_t i = 0;
+    while (i < t.size())
+    {
+        bool space = isspace(static_cast<unsigned char>(t[i])) != 0;
+        size_t tokenFirst = line.pieces.size();
+        size_t j = i;
+        while (j < t.size() && (isspace(static_cast<unsigned char>(t[j])) != 0) == space)
+        {
+            // Dentro de um token, "#n" vira um pedaço de parâmetro. Como na
+            // substituição original, o marcador tem um único dígito: "#10" é
+            // o #1 seguido de '0'.
+            if (!space && t[j] == '#' && j + 1 < t.size() && isdigit(static_cast<unsigned char>(t[j + 1])))
+            {
+                if (j > i)
+                    line.pieces.push_back({-1, static_cast<uint32_t>(i), static_cast<uint32_t>(j - i)});
+                int param = t[j + 1] - '1';
+                line.pieces.push_back({param, static_cast<uint32_t>(j), 2});
+                i = j = j + 2;
+                continue;
+            }
+            j++;
+        }
+        if (j > i)
+            line.pieces.push_back({-1, static_cast<uint32_t>(i), static_cast<uint32_t>(j - i)});
+        if (!space && line.pieces.size() > tokenFirst)
+            line.tokens.emplace_back(static_cast<uint32_t>(tokenFirst), static_cast<uint32_t>(line.pieces.size()));
+        i = j;
+    }
+
+    if (!line.tokens.empty())
     {
-        if (!token.empty() && token.back() == ',')
+        line.calleeIsLiteral = true;
+        for (uint32_t p = line.tokens[0].first; p < line.tokens[0].second; p++)
         {
-            token.pop_back();
+            if (line.pieces[p].param >= 0)
+                line.calleeIsLiteral = false;
         }
-        if (!token.empty())
-            tokens.push_back(token);
     }
+    return line;
+}
 
-    return tokens;
+void Preprocessor::append_piece(const MacroLine &line, const MacroPiece &piece, const ExpansionFrame &frame,
+                                pmr::string &out)
+{
+    // Parâmetro sem argumento correspondente fica como está (#n).
+    if (piece.param >= 0 && static_cast<size_t>(piece.param) < frame.argCount)
+    {
+        LOG_TRACE(log, "Substituindo " << string_view(line.text).substr(piece.begin, piece.length) << " por " << frame.args[piece.param]);
+        out += frame.args[piece.param];
+    }
+    else
+    {
+        out.append(line.text, piece.begin, piece.length);
+    }
 }
 
-// Método privado para expandir uma macro, com suporte a chamadas aninhadas (recursão).
-void Preprocessor:: expand_macro(const string& name, const vector<string>& args, ofstream& output_file) {
-    // Busca a macro na Tabela de Nomes de Macro (MNT).
-    const MNTItem& macroInfo = mnt.at(name);
-
-    // Itera sobre o corpo da macro na Tabela de Definição de Macro (MDT).
-    for (size_t i = macroInfo.mdtStartIndex; i < mdt.size(); i++) {
-        string macroLine = mdt[i];
-        cout << "Processando linha da macro: " << macroLine << endl;
-        
-        // Para a expansão ao encontrar o "ENDMACRO" da definição atual.
-        if (mdt[i] == "ENDMACRO") break;
-
-        // Substitui os marcadores de parâmetro (#1, #2) pelos argumentos reais da chamada.
-        for (size_t j = 0; j < args.size(); j++) {
-            string placeholder = "#" + to_string(j + 1);
-            size_t pos = macroLine.find(placeholder);
-            while (pos != string::npos) {
-                macroLine.replace(pos, placeholder.length(), args[j]);
-                cout << "Substituindo " << placeholder << " por " << args[j] << endl;
-                pos = macroLine.find(placeholder, pos + args[j].length());
+// Monta o 1º token da linha (sem a vírgula final) e o procura na MNT. Quando o
+// token não depende dos argumentos, o resultado fica em cache na própria linha.
+const MNTItem *Preprocessor::find_callee(MacroLine &line, const ExpansionFrame &frame)
+{
+    if (line.tokens.empty())
+        return nullptr;
+    if (line.calleeIsLiteral && line.calleeGeneration == mntGeneration)
+        return line.callee;
+
+    lookupKey.clear();
+    for (uint32_t p = line.tokens[0].first; p < line.tokens[0].second; p++)
+        append_piece(line, line.pieces[p], frame, lookupKey);
+    if (!lookupKey.empty() && lookupKey.back() == ',')
+        lookupKey.pop_back();
+    // A MNT tem os nomes em maiúsculas; a linha pode estar na caixa do fonte.
+    if (preOutput)
+        fold_upper(lookupKey.data(), lookupKey.size());
+
+    auto it = mnt.find(lookupKey);
+    const MNTItem *callee = it == mnt.end() ? nullptr : &it->second;
+    if (line.calleeIsLiteral)
+    {
+        line.callee = callee;
+        line.calleeGeneration = mntGeneration;
+    }
+    return callee;
+}
+
+Preprocessor::ExpansionFrame &Preprocessor::push_frame(size_t depth, int lineNumber)
+{
+    if (depth >= limits.maxDepth)
+    {
+        throw runtime_error("Linha " + to_string(lineNumber) + ": expansao de macros excede a profundidade maxima (" +
+                            to_string(limits.maxDepth) + ")");
+    }
+    if (depth == stack.size())
+        stack.emplace_back(&arena);
+    macroCalls++;
+    peakDepth = max(peakDepth, depth + 1);
+    return stack[depth];
+}
+
+// Expande uma chamada de macro. Chamadas aninhadas empilham um novo quadro na
+// pilha explícita em vez de recursão, então a profundidade fica limitada por
+// `limits.maxDepth` e não pela pilha nativa.
+// Os argumentos da chamada estão nos `callArgCount` primeiros de `callArgs`.
+void Preprocessor::expand_macro(const MNTItem &macroInfo, int lineNumber, LineSink &output)
+{
+    size_t depth = 0;
+    ExpansionFrame &root = push_frame(depth++, lineNumber);
+    root.macro = &macroInfo;
+    root.next = macroInfo.mdtBegin;
+    root.args.swap(callArgs);
+    root.argCount = callArgCount;
+
+    while (depth > 0)
+    {
+        ExpansionFrame &frame = stack[depth - 1];
+        // Fim do corpo [mdtBegin, mdtEnd): volta para quem chamou.
+        if (frame.next == frame.macro->mdtEnd)
+        {
+            depth--;
+            continue;
+        }
+
+        MacroLine &macroLine = mdt[frame.next++];
+        LOG_TRACE(log, "Processando linha da macro: " << macroLine.text);
+
+        // Verifica se a linha é uma chamada de macro aninhada.
+        if (const MNTItem *callee = find_callee(macroLine, frame))
+        {
+            LOG_TRACE(log, "Encontrada macro aninhada: " << callee->name);
+            // push_frame pode realocar a pilha: `frame` não vale mais daqui em diante.
+            ExpansionFrame &child = push_frame(depth, lineNumber);
+            const ExpansionFrame &parent = stack[depth - 1];
+            child.macro = callee;
+            child.next = callee->mdtBegin;
+
+            // Monta os argumentos a partir dos tokens já marcados, reaproveitando
+            // as strings do quadro (as que sobram ficam para a próxima chamada).
+            size_t count = 0;
+            for (size_t k = 1; k < macroLine.tokens.size(); k++)
+            {
+                if (count == child.args.size())
+                    child.args.emplace_back();
+                pmr::string &arg = child.args[count];
+                arg.clear();
+                for (uint32_t p = macroLine.tokens[k].first; p < macroLine.tokens[k].second; p++)
+                    append_piece(macroLine, macroLine.pieces[p], parent, arg);
+                if (!arg.empty() && arg.back() == ',')
+                    arg.pop_back();
+                if (arg.empty())
+                    continue;
+                LOG_TRACE(log, "Argumento aninhado: " << arg);
+                count++;
             }
+            child.argCount = count;
+            depth++;
         }
-        
-        // Após a substituição, verifica se a linha resultante é uma chamada de macro aninhada.
-        vector<string> macroTokens = split(macroLine);
-        if (!macroTokens.empty() && mnt.count(macroTokens[0])) {
-            // É uma chamada aninhada. Coleta os argumentos e chama a si mesma recursivamente.
-            cout << "Encontrada macro aninhada: " << macroTokens[0] << endl;
-            vector<string> nested_args;
-            for (size_t k = 1; k < macroTokens.size(); k++) {
-                nested_args.push_back(macroTokens[k]);
-                cout << "Argumento aninhado: " << macroTokens[k] << endl;
+        else
+        {
+            if (++expandedLines > expandedLineLimit)
+            {
+                throw runtime_error("Linha " + to_string(lineNumber) + ": expansao de macros excede o limite de " +
+                                    to_string(expandedLineLimit) + " linhas geradas");
             }
-            expand_macro(macroTokens[0], nested_args, output_file);
-        } else {
-            // Se não for uma chamada aninhada, escreve a linha expandida no arquivo de saída.
-            output_file << macroLine << endl;
+            // Se não for uma chamada aninhada, concatena os pedaços com os
+            // argumentos reais e escreve a linha expandida na saída.
+            expanded.clear();
+            for (const MacroPiece &piece : macroLine.pieces)
+                append_piece(macroLine, piece, frame, expanded);
+            if (preOutput)
+            {
+                preOutput->write(expanded);
+                fold_upper(expanded.data(), expanded.size());
+            }
+            output.write(expanded);
+        }
+    }
+}
+
+// Guarda uma linha do corpo da macro em definição na MDT, na caixa do fonte.
+void Preprocessor::define_macro_line(const MNTItem &macro, string_view line, string_view foldedLine)
+{
+    // Substitui os nomes dos parâmetros por marcadores posicionais (ex: #1, #2).
+    // Os nomes são procurados na linha em maiúsculas e trocados nas mesmas
+    // posições das duas cópias, que continuam com o mesmo tamanho.
+    macroBody.assign(line);
+    foldedBody.assign(foldedLine);
+    for (size_t i = 0; i < macro.params.size(); i++) {
+        char placeholder[24] = {'#'};
+        size_t placeholderLength = to_chars(placeholder + 1, placeholder + sizeof(placeholder), i + 1).ptr - placeholder;
+        const pmr::string &param = macro.params[i];
+        size_t pos = foldedBody.find(param);
+        while(pos!= string::npos) {
+            macroBody.replace(pos, param.length(), placeholder, placeholderLength);
+            foldedBody.replace(pos, param.length(), placeholder, placeholderLength);
+            pos = foldedBody.find(param, pos + placeholderLength);
         }
     }
+    // Compila a linha uma única vez; a expansão só preenche os parâmetros.
+    mdt.push_back(compile_macro_line(macroBody));
 }
 
 void Preprocessor::process(const string &inputFilename, const string &outputFilename)
 {
-    ifstream inputFile(inputFilename);
-    ofstream outputFile(outputFilename);
+    // Só o .pre: o arquivo é a cópia lateral, na caixa do fonte.
+    FileLineSink outputFile(outputFilename);
+    NullLineSink discarded;
+    LineSink *previous = preOutput;
+    preOutput = &outputFile;
+    try
+    {
+        process(inputFilename, discarded);
+    }
+    catch (...)
+    {
+        preOutput = previous;
+        throw;
+    }
+    preOutput = previous;
+}
+
+void Preprocessor::reset()
+{
+    // Os containers soltam a memória da execução anterior antes de a arena
+    // voltar ao início do bloco.
+    discard(mnt, &arena);
+    discard(mdt, &arena);
+    discard(stack, &arena);
+    discard(expanded, &arena);
+    discard(tokens, &arena);
+    discard(callArgs, &arena);
+    tokenCount = 0;
+    callArgCount = 0;
+    discard(macroBody, &arena);
+    discard(foldedBody, &arena);
+    discard(lookupKey, &arena);
+    arena.reset();
+    mntGeneration++;
+    expandedLines = 0;
+    macroCalls = 0;
+    peakDepth = 0;
+}
+
+void Preprocessor::process(const string &inputFilename, LineSink &outputFile)
+{
+    // Arquivo mapeado em memória: as linhas são views, sem cópia por getline.
+    PhaseClock clock(stats ? &stats->preprocess : nullptr);
+    SourceBuffer inputFile(inputFilename);
+    run(inputFile, outputFile);
+}
+
+void Preprocessor::process(SourceBuffer &inputFile, LineSink &outputFile)
+{
+    PhaseClock clock(stats ? &stats->preprocess : nullptr);
+    run(inputFile, outputFile);
+}
 
-    if (!inputFile.is_open() || !outputFile.is_open())
+void Preprocessor::process_text(string_view source, LineSink &outputFile)
+{
+    PhaseClock clock(stats ? &stats->preprocess : nullptr);
+    // O fonte do chamador é só leitura: a cópia em maiúsculas fica em
+    // `foldedSource`, que mantém a capacidade entre chamadas.
+    foldedSource.assign(source);
+    fold_upper(foldedSource.data(), foldedSource.size());
+    run(preOutput ? source : string_view(foldedSource), foldedSource, outputFile);
+}
+
+void Preprocessor::run(SourceBuffer &inputFile, LineSink &outputFile)
+{
+    // Sem cópia lateral o texto vai para maiúsculas uma única vez, no próprio
+    // buffer (mapeamento privado); com ela, numa cópia, mantendo o original.
+    if (!preOutput)
     {
-        throw runtime_error("Nao foi possivel abrir os arquivos de pre-processamento.");
+        string_view folded = inputFile.fold_upper_in_place();
+        run(folded, folded, outputFile);
+        return;
     }
+    foldedSource.assign(inputFile.text());
+    fold_upper(foldedSource.data(), foldedSource.size());
+    run(inputFile.text(), foldedSource, outputFile);
+}
+
+// Uma linha do fonte que passa sem mudanças: em maiúsculas para a saída e na
+// caixa do fonte para a cópia lateral.
+void Preprocessor::write_line(string_view line, string_view foldedLine, LineSink &outputFile)
+{
+    outputFile.write(foldedLine);
+    if (preOutput)
+        preOutput->write(line);
+}
+
+// Os tokens, nomes de macro e argumentos vêm de `folded`; as linhas
+// copiadas e o corpo das macros, de `source`.
+void Preprocessor::run(string_view source, string_view folded, LineSink &outputFile)
+{
+    reset();
+    expandedLineLimit = limits.expanded_line_limit(source.size());
+    size_t copiedLines = 0;
 
-    string line;
     bool isMacro = false; // Flag pra inicio de macro
-    MNTItem currentMacro;
+    MNTItem currentMacro(&arena);
 
-    while (getline(inputFile, line))
+    // Linhas classificadas por uma varredura vetorizada, em janelas de
+    // `scanWindow` bytes que terminam num '\n' (mesma divisão do SourceBuffer:
+    // um '\n' final não cria linha vazia). A classificação ocupa o mesmo
+    // buffer em todas as janelas, sem crescer com o arquivo.
+    size_t lineIndex = 0;
+    for (size_t windowStart = 0; windowStart < folded.size();)
     {
-        string upperLine = line;
-
-        // Converte linha pra maiúsculas
-        for (size_t i = 0; i < upperLine.size(); i++)
+        size_t windowEnd = folded.size();
+        if (folded.size() - windowStart > scanWindow)
         {
-            upperLine[i] = toupper(static_cast<unsigned char>(upperLine[i]));
+            size_t newline = folded.find('\n', windowStart + scanWindow);
+            if (newline != string_view::npos)
+                windowEnd = newline + 1;
         }
+        string_view window = folded.substr(windowStart, windowEnd - windowStart);
+        string_view sourceWindow = source.substr(windowStart, windowEnd - windowStart);
+        windowStart = windowEnd;
+        scan_lines(window, lineInfo);
 
-        vector<string> tokens = split(upperLine);
-        // Se a linha estiver vazia, apenas copia (se não estiver dentro de uma macro)
-        if (tokens.empty())
+        for (const LineInfo &info : lineInfo)
         {
-            if (!isMacro)
-                outputFile << line << endl;
-            continue;
-        }
+            lineIndex++;
+            string_view line = sourceWindow.substr(info.begin, info.length);
+            string_view foldedLine = window.substr(info.begin, info.length);
 
-        bool line_handled = false;
-        for (const auto &token : tokens)
-        {
-            if (token == "MACRO")
+            // Linhas em branco e comentários passam direto, sem divisão em tokens.
+            // Em branco: apenas copia (se não estiver dentro de uma macro).
+            // Comentário: copia, ou vai para o corpo da macro em definição.
+            if (info.kind != LineKind::CODE)
             {
-                isMacro = true;
-                // Extrai o nome da macro e seus parâmetros. (Máximo de 2)
-                string label_part = tokens[0];
-                currentMacro.name = label_part.substr(0, label_part.find(':'));
-                currentMacro.params.clear();
-                for (size_t i = 2; i < tokens.size(); i++)
+                if (!isMacro)
                 {
-                    currentMacro.params.push_back(tokens[i]);
+                    write_line(line, foldedLine, outputFile);
+                    copiedLines++;
                 }
-                currentMacro.mdtStartIndex = mdt.size();
-                line_handled = true;
-                break; 
+                else if (info.kind == LineKind::COMMENT)
+                {
+                    define_macro_line(currentMacro, line, foldedLine);
+                }
+                continue;
             }
 
-            // Detecta o fim de uma definição de macro.
-            if (token == "ENDMACRO")
+            // Só o trecho antes do ';' conta para MACRO/ENDMACRO e chamadas.
+            tokenCount = split(foldedLine.substr(0, info.codeLength), tokens);
+            if (tokenCount == 0)
             {
-                isMacro = false;
-                mnt[currentMacro.name] = currentMacro; // Salva a macro na MNT.
-                mdt.push_back("ENDMACRO");             // Adiciona um marcador de fim na MDT.
-                line_handled = true;
-                break;
+                if (!isMacro)
+                {
+                    write_line(line, foldedLine, outputFile);
+                    copiedLines++;
+                }
+                continue;
             }
-        }
 
-        if (line_handled) {
-            continue;
-        }
+            bool line_handled = false;
+            for (size_t t = 0; t < tokenCount; t++)
+            {
+                const pmr::string &token = tokens[t];
+                if (token == "MACRO")
+                {
+                    isMacro = true;
+                    // Extrai o nome da macro e seus parâmetros. (Máximo de 2)
+                    string_view label_part = tokens[0];
+                    currentMacro.name.assign(label_part.substr(0, label_part.find(':')));
+                    currentMacro.params.clear();
+                    for (size_t i = 2; i < tokenCount; i++)
+                    {
+                        currentMacro.params.push_back(tokens[i]);
+                    }
+                    currentMacro.mdtBegin = mdt.size();
+                    line_handled = true;
+                    break; 
+                }
 
-        // Se estiver no estado de definição, armazena a linha na MDT.
-        if (isMacro) {
-            // Substitui os nomes dos parâmetros por marcadores posicionais (ex: #1, #2).
-            for (size_t i = 0; i < currentMacro.params.size(); i++) {
-                string placeholder = "#" + to_string(i + 1);
-                string param = currentMacro.params[i];
-                size_t pos = line.find(param);
-                while(pos!= string::npos) {
-                    line.replace(pos, param.length(), placeholder);
-                    pos = line.find(param, pos + placeholder.length());
+                // Detecta o fim de uma definição de macro.
+                if (token == "ENDMACRO")
+                {
+                    isMacro = false;
+                    currentMacro.mdtEnd = mdt.size();      // Fim do corpo na MDT.
+                    lookupKey.assign(currentMacro.name);
+                    mnt.insert_or_assign(lookupKey, std::move(currentMacro)); // Salva a macro na MNT.
+                    mntGeneration++;
+                    line_handled = true;
+                    break;
                 }
             }
-            mdt.push_back(line);
-        } else {
-            // Se não estiver definindo, verifica se é uma chamada de macro.
-            string potentialMacro = tokens[0];
-            if (potentialMacro.back() == ':') { 
-                 potentialMacro.pop_back();
+
+            if (line_handled) {
+                continue;
             }
 
-            // Se o primeiro token da linha é um nome de macro conhecido
-            // Usando como unordered_map para busca - retorna 0 ou 1
-            if (mnt.count(potentialMacro)) {
-                vector<string> args;
-                
-                // Para definição SWAP:           (TODO: Vai ser usada?)
-                //                MACRO &A, &B, &T
-                size_t start = 1;
-                if (!tokens.empty() && tokens[0].back() == ':') {
-                    // Para definição SWAP: MACRO &A, &B, &T
-                    start = 2;
-                }
-                for (size_t i = start; i < tokens.size(); i++) {
-                    args.push_back(tokens[i]);
+            // Se estiver no estado de definição, armazena a linha na MDT.
+            if (isMacro) {
+                define_macro_line(currentMacro, line, foldedLine);
+            } else {
+                // Se não estiver definindo, verifica se é uma chamada de macro.
+                pmr::string &potentialMacro = lookupKey;
+                potentialMacro.assign(tokens[0]);
+                if (potentialMacro.back() == ':') { 
+                     potentialMacro.pop_back();
                 }
 
-                cout << "Expansao da macro: " << potentialMacro << " com " << args.size() << " argumentos." << endl;
-                expand_macro(potentialMacro, args, outputFile);
+                // Se o primeiro token da linha é um nome de macro conhecido
+                // Usando como unordered_map para busca
+                auto macro = mnt.find(potentialMacro);
+                if (macro != mnt.end()) {
+                    // Argumentos escritos sobre as strings da chamada anterior
+                    // (expand_macro troca o vetor com o do quadro da pilha).
+                    pmr::vector<pmr::string> &args = callArgs;
+                
+                    // Para definição SWAP:           (TODO: Vai ser usada?)
+                    //                MACRO &A, &B, &T
+                    size_t start = 1;
+                    if (tokens[0].back() == ':') {
+                        // Para definição SWAP: MACRO &A, &B, &T
+                        start = 2;
+                    }
+                    size_t count = 0;
+                    for (size_t i = start; i < tokenCount; i++) {
+                        if (count == args.size())
+                            args.emplace_back();
+                        args[count++].assign(tokens[i]);
+                    }
+                    callArgCount = count;
+
+                    LOG_TRACE(log, "Expansao da macro: " << potentialMacro << " com " << count << " argumentos.");
+                    expand_macro(macro->second, static_cast<int>(lineIndex), outputFile);
 
                
-            } else {
-                // Sem macros
-                outputFile << line << endl;
+                } else {
+                    // Sem macros
+                    write_line(line, foldedLine, outputFile);
+                    copiedLines++;
+                }
             }
         }
     }
+    outputFile.close();
+    if (preOutput)
+        preOutput->close();
+
+    if (stats)
+    {
+        stats->sourceLines += lineIndex;
+        stats->expandedLines += copiedLines + expandedLines;
+        stats->macroExpansions += macroCalls;
+        stats->peakMacroDepth = max(stats->peakMacroDepth, peakDepth);
+        stats->arenaBytes += arena.used();
+    }
 }
\ No newline at end of file
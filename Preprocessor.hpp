@@ -1,36 +1,176 @@
 #ifndef PREPROCESSOR_HPP
 #define PREPROCESSOR_HPP
 
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <cstdint>
+#include "LineStream.hpp"
+#include "Log.hpp"
+#include "Memory.hpp"
+#include "SourceBuffer.hpp"
+#include "Stats.hpp"
+#include "TextScan.hpp"
 
 using namespace std;
 
 // Tabela de Nomes de Macro (MNT).
-// Contém o nome, a lista de parâmetros e onde é definida na MDT.
+// Contém o nome, a lista de parâmetros e o intervalo [mdtBegin, mdtEnd) do
+// corpo na MDT. Como as tabelas, fica na arena do Preprocessor.
 struct MNTItem {
-    string name;
-    vector<string> params;
-    int mdtStartIndex;
+    explicit MNTItem(pmr::memory_resource* resource) : name(resource), params(resource) {}
+
+    pmr::string name;
+    pmr::vector<pmr::string> params;
+    size_t mdtBegin = 0;
+    size_t mdtEnd = 0;
+};
+
+// Limites da expansão de macros. Ao ultrapassá-los o pré-processamento falha
+// com erro em vez de estourar a pilha ou a memória (ex: macro recursiva).
+struct MacroLimits {
+    size_t maxDepth = 256;        // chamadas aninhadas ativas
+    size_t maxExpandedLines = 0;  // linhas geradas por expansão no arquivo (0: automático)
+
+    // Limite automático de linhas geradas: cresce com o fonte, para que
+    // entradas grandes não esbarrem num teto fixo, mas nunca fica abaixo de
+    // `minAutoLines`.
+    static constexpr size_t minAutoLines = size_t(1) << 24;
+    static constexpr size_t autoLinesPerByte = 64;
+    size_t expanded_line_limit(size_t sourceBytes) const
+    {
+        if (maxExpandedLines != 0)
+            return maxExpandedLines;
+        return max(minAutoLines, sourceBytes > SIZE_MAX / autoLinesPerByte ? SIZE_MAX : sourceBytes * autoLinesPerByte);
+    }
 };
 
-// Lê o arquivo.asm, expande todas as macros e gera o arquivo.pre.
+// Pedaço de uma linha de macro compilada: texto literal ou parâmetro (#n, um
+// dígito).
+// Ambos apontam para o trecho [begin, begin+length) de MacroLine::text.
+struct MacroPiece {
+    int param;          // índice do argumento (0 = #1) ou -1 para literal (e #0)
+    uint32_t begin;
+    uint32_t length;
+};
+
+// Linha do corpo de uma macro compilada uma única vez na definição. A linha é
+// quebrada em pedaços (literais e parâmetros) e os tokens separados por
+// espaço já ficam marcados, de modo que a expansão só concatena pedaços e
+// preenche os parâmetros, sem find/replace nem nova divisão da linha.
+struct MacroLine {
+    explicit MacroLine(pmr::memory_resource* resource) : text(resource), pieces(resource), tokens(resource) {}
+
+    pmr::string text;                            // linha com os marcadores #1, #2...
+    pmr::vector<MacroPiece> pieces;
+    pmr::vector<pair<uint32_t, uint32_t>> tokens; // [primeiro, último) pedaço de cada token
+    bool calleeIsLiteral = false;           // 1º token sem parâmetros (candidato fixo a chamada)
+    // Cache da busca do 1º token na MNT (válido enquanto mntGeneration não mudar).
+    const MNTItem* callee = nullptr;
+    unsigned calleeGeneration = ~0u;
+};
+
+// Lê o arquivo.asm, expande todas as macros e entrega as linhas expandidas
+// a um LineSink (o montador) e, opcionalmente, a uma cópia lateral (o .pre).
+// O fonte passa uma vez por fold_upper/scan_lines (TextScan.hpp): a saída
+// principal recebe as linhas já em maiúsculas e a cópia lateral as mesmas
+// linhas na caixa do fonte.
 class Preprocessor {
 public:
+    // As mensagens de depuração (nível TRACE) vão para `log` (cout por padrão;
+    // no modo lote cada arquivo tem o seu buffer para manter a saída em ordem).
+    explicit Preprocessor(Logger& log = Logger::standard(), MacroLimits limits = {}) : log(log), limits(limits) {}
+
+    void process(const string& input_filename, LineSink& output);
+    // Idem, com o fonte já aberto (ex: o mesmo buffer usado na chave do cache).
+    void process(SourceBuffer& input, LineSink& output);
+    // Atalho que grava a saída diretamente no arquivo .pre.
     void process(const string& input_filename, const string& output_filename);
+    // Pré-processa um fonte já em memória (linhas separadas por '\n').
+    void process_text(string_view source, LineSink& output);
+    // Cópia lateral da saída (o .pre), na caixa do fonte; nulo para nenhuma.
+    // Com ela o fonte é convertido numa cópia em vez de no próprio buffer.
+    void set_pre_output(LineSink* sink) { preOutput = sink; }
+    // Esquece as macros definidas e volta a arena ao início, mantendo o bloco
+    // dela. Chamado no início de cada process(), então a mesma instância pode
+    // ser reaproveitada.
+    void reset();
+    // Acumula tempos e contadores do pré-processamento em `stats` (--stats).
+    void set_stats(CompileStats* target) { stats = target; }
 
 private:
-    // Tabela de Nomes de Macro (MNT): associa nomes das macros às suas informações.
-    unordered_map<string, MNTItem> mnt;
-    // Tabela de Definição de Macro (MDT): armazena o corpo de todas as macros. (Referenciada pelo indice mdtStartIndex na MNT)
-    vector<string> mdt;
+    // Chamada de macro em andamento na pilha de expansão.
+    struct ExpansionFrame {
+        explicit ExpansionFrame(pmr::memory_resource* resource) : args(resource) {}
+
+        const MNTItem* macro = nullptr;
+        size_t next = 0;        // próxima linha da MDT a expandir
+        pmr::vector<pmr::string> args; // só os `argCount` primeiros valem
+        size_t argCount = 0;
+    };
 
-    // Função para dividir uma linha em tokens.
-    vector<string> split(const string& s);
-    void expand_macro(const string& name, const vector<string>& args, ofstream& output_file);
+    Logger& log;
+    MacroLimits limits;
+    CompileStats* stats = nullptr;
+    // Com cópia lateral o fonte é convertido numa cópia e o texto original é
+    // mantido: a MDT guarda as linhas na caixa do fonte, e as expandidas são
+    // convertidas só na hora de ir para a saída principal.
+    LineSink* preOutput = nullptr;
 
+    // Tudo o que uma execução aloca (MNT, MDT, pilha, tokens e argumentos) vem
+    // desta arena, descartada de uma vez no reset(). Declarada antes das
+    // tabelas, que são destruídas antes dela.
+    Arena arena;
+    // Tabela de Nomes de Macro (MNT): associa nomes das macros às suas informações.
+    pmr::unordered_map<pmr::string, MNTItem> mnt{&arena};
+    // Tabela de Definição de Macro (MDT): armazena o corpo de todas as macros,
+    // já compilado, sem marcadores de fim. (Referenciada pelos intervalos da MNT)
+    pmr::vector<MacroLine> mdt{&arena};
+    // Incrementado a cada macro definida; invalida os caches de MacroLine::callee.
+    unsigned mntGeneration = 0;
+    // Buffer reaproveitado para montar as linhas expandidas.
+    pmr::string expanded{&arena};
+    // Pilha explícita de expansão. Os quadros não são destruídos ao sair de
+    // uma chamada, para reaproveitar os vetores de argumentos.
+    pmr::vector<ExpansionFrame> stack{&arena};
+    size_t expandedLines = 0;
+    size_t expandedLineLimit = 0; // limits.expanded_line_limit() do fonte atual
+    size_t macroCalls = 0;
+    size_t peakDepth = 0;
+    // Buffers reaproveitados entre linhas e entre fontes: cópia em maiúsculas
+    // do fonte (process_text ou com cópia lateral) e classificação das
+    // linhas de uma janela.
+    static constexpr size_t scanWindow = 64 * 1024;
+    string foldedSource;
+    vector<LineInfo> lineInfo;
+    // Buffers da linha atual, na arena: tokens, argumentos de uma chamada,
+    // corpo de macro antes de compilar (no texto original e em maiúsculas) e
+    // nome procurado na MNT. Os vetores de strings nunca encolhem (só os
+    // `tokenCount`/`callArgCount` primeiros valem): destruir uma string da
+    // arena perde o buffer dela, e a próxima linha alocaria outro.
+    pmr::vector<pmr::string> tokens{&arena};
+    size_t tokenCount = 0;
+    pmr::vector<pmr::string> callArgs{&arena};
+    size_t callArgCount = 0;
+    pmr::string macroBody{&arena};
+    pmr::string foldedBody{&arena};
+    pmr::string lookupKey{&arena};
 
+    // `folded` é `source` em maiúsculas, com as mesmas posições (pode ser o
+    // mesmo buffer quando não há cópia lateral).
+    void run(SourceBuffer& input, LineSink& output);
+    void run(string_view source, string_view folded, LineSink& output);
+    void write_line(string_view line, string_view foldedLine, LineSink& output);
+    // Divide uma linha em tokens (separados por espaço, sem a vírgula final),
+    // escritos sobre as strings de `tokens`. Retorna quantos foram escritos.
+    static size_t split(string_view s, pmr::vector<pmr::string>& tokens);
+    void define_macro_line(const MNTItem& macro, string_view line, string_view foldedLine);
+    MacroLine compile_macro_line(string_view text);
+    void append_piece(const MacroLine& line, const MacroPiece& piece, const ExpansionFrame& frame, pmr::string& out);
+    const MNTItem* find_callee(MacroLine& line, const ExpansionFrame& frame);
+    ExpansionFrame& push_frame(size_t depth, int lineNumber);
+    void expand_macro(const MNTItem& macroInfo, int lineNumber, LineSink& output);
 };
 
 #endif // PREPROCESSOR_HPP
\ No newline at end of file
@@ -0,0 +1,217 @@
+#include "Protocol.hpp"
+#include <cerrno>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace
+{
+    constexpr const char *MAGIC = "ASM1\n";
+    // Limite de um campo: protege o servidor de um tamanho absurdo no cabeçalho.
+    constexpr size_t MAX_FIELD = size_t(1) << 30;
+
+    void write_all(int fd, const char *data, size_t size)
+    {
+        while (size > 0)
+        {
+            // MSG_NOSIGNAL: um cliente que desconectou não derruba o servidor com SIGPIPE.
+            ssize_t n = send(fd, data, size, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                throw runtime_error(string("Falha ao enviar mensagem: ") + strerror(errno));
+            data += n;
+            size -= static_cast<size_t>(n);
+        }
+    }
+
+    // Leitura bufferizada de um descritor, byte a byte ou em blocos.
+    class Reader
+    {
+    public:
+        explicit Reader(int fd) : fd(fd) {}
+
+        // Lê até '\n' (exclusive). Falso se a conexão fechar antes.
+        bool line(string &out)
+        {
+            out.clear();
+            while (true)
+            {
+                if (pos == size && !fill())
+                    return false;
+                char c = buffer[pos++];
+                if (c == '\n')
+                    return true;
+                out.push_back(c);
+                if (out.size() > 4096)
+                    throw runtime_error("Mensagem malformada: cabecalho muito longo");
+            }
+        }
+
+        void bytes(string &out, size_t count)
+        {
+            out.clear();
+            out.reserve(count);
+            while (out.size() < count)
+            {
+                if (pos == size && !fill())
+                    throw runtime_error("Mensagem truncada");
+                size_t take = min(count - out.size(), size - pos);
+                out.append(buffer + pos, take);
+                pos += take;
+            }
+        }
+
+    private:
+        bool fill()
+        {
+            while (true)
+            {
+                ssize_t n = read(fd, buffer, sizeof(buffer));
+                if (n < 0 && errno == EINTR)
+                    continue;
+                if (n < 0)
+                    throw runtime_error(string("Falha ao receber mensagem: ") + strerror(errno));
+                pos = 0;
+                size = static_cast<size_t>(n);
+                return n > 0;
+            }
+        }
+
+        int fd;
+        char buffer[65536];
+        size_t pos = 0;
+        size_t size = 0;
+    };
+}
+
+const string *Message::find(const string &name) const
+{
+    for (const auto &field : fields)
+    {
+        if (field.first == name)
+            return &field.second;
+    }
+    return nullptr;
+}
+
+string Message::get(const string &name, const string &fallback) const
+{
+    const string *value = find(name);
+    return value ? *value : fallback;
+}
+
+vector<string> Message::all(const string &name) const
+{
+    vector<string> values;
+    for (const auto &field : fields)
+    {
+        if (field.first == name)
+            values.push_back(field.second);
+    }
+    return values;
+}
+
+void send_message(int fd, const Message &message)
+{
+    string data = MAGIC;
+    for (const auto &field : message.fields)
+    {
+        data += field.first;
+        data += ' ';
+        data += to_string(field.second.size());
+        data += '\n';
+        data += field.second;
+    }
+    data += "end 0\n";
+    write_all(fd, data.data(), data.size());
+}
+
+bool receive_message(int fd, Message &message)
+{
+    message.fields.clear();
+    Reader reader(fd);
+    string header;
+    if (!reader.line(header))
+        return false;
+    if (header + "\n" != MAGIC)
+        throw runtime_error("Mensagem malformada: cabecalho invalido");
+
+    while (true)
+    {
+        if (!reader.line(header))
+            throw runtime_error("Mensagem truncada");
+        size_t space = header.rfind(' ');
+        size_t length = 0;
+        const char *digits = header.data() + (space == string::npos ? 0 : space + 1);
+        auto parsed = from_chars(digits, header.data() + header.size(), length);
+        if (space == string::npos || space == 0 || parsed.ec != errc() || parsed.ptr != header.data() + header.size() ||
+            length > MAX_FIELD)
+        {
+            throw runtime_error("Mensagem malformada: campo invalido");
+        }
+        string name = header.substr(0, space);
+        if (name == "end")
+            return true;
+        string value;
+        reader.bytes(value, length);
+        message.add(name, std::move(value));
+    }
+}
+
+int connect_socket(const string &path)
+{
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path))
+        return -1;
+    memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+    if (connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool peer_is_owner(int fd)
+{
+    ucred peer{};
+    socklen_t length = sizeof(peer);
+    if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &peer, &length) != 0 || length != sizeof(peer))
+        return false;
+    return peer.uid == getuid();
+}
+
+string default_socket_path()
+{
+    if (const char *env = getenv("ASM_SOCKET"); env && *env)
+        return env;
+    // $XDG_RUNTIME_DIR já é só do usuário.
+    if (const char *runtime = getenv("XDG_RUNTIME_DIR"); runtime && *runtime)
+        return string(runtime) + "/asm-compiler.sock";
+
+    // Em /tmp, qualquer um criaria antes um socket com o nome esperado: o
+    // socket fica num diretório do usuário, fechado para os outros.
+    string directory = "/tmp/asm-compiler-" + to_string(getuid());
+    if (mkdir(directory.c_str(), 0700) != 0 && errno != EEXIST)
+        throw runtime_error("Nao foi possivel criar " + directory + ": " + strerror(errno));
+    struct stat info;
+    if (lstat(directory.c_str(), &info) != 0 || !S_ISDIR(info.st_mode) || info.st_uid != getuid() ||
+        (info.st_mode & 077) != 0)
+    {
+        throw runtime_error("Diretorio do socket inseguro (outro dono ou aberto a outros usuarios): " + directory);
+    }
+    return directory + "/server.sock";
+}
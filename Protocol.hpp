@@ -0,0 +1,52 @@
+#ifndef PROTOCOL_HPP
+#define PROTOCOL_HPP
+
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Mensagem trocada entre o cliente (tools/asmc.cpp) e o servidor: uma lista
+// ordenada de campos (nome, valor). Na conexão cada campo vira
+// "<nome> <tamanho>\n<bytes>", depois do cabeçalho "ASM1\n" e antes do campo
+// final "end 0\n"; os valores podem ter qualquer byte.
+//
+// Pedidos (campo "type"):
+//   compile  — cwd, arg...: roda a linha de comando do `compiler` no
+//              diretório cwd (o do cliente); resposta com status, out
+//              (stdout) e err (stderr).
+//   assemble — source (texto do .asm) ou path, e optimize=1 opcional; resposta
+//              com status, words (o .o2) e diagnostics (erros). Um path
+//              relativo parte do campo cwd, obrigatório nesse caso.
+//   shutdown — termina o servidor depois dos pedidos em andamento.
+struct Message {
+    vector<pair<string, string>> fields;
+
+    void add(const string& name, string value) { fields.emplace_back(name, std::move(value)); }
+    // Primeiro campo com o nome, ou nulo.
+    const string* find(const string& name) const;
+    // Valor do campo, ou `fallback` se não existir.
+    string get(const string& name, const string& fallback = "") const;
+    // Todos os valores com o nome, na ordem (ex: os "arg").
+    vector<string> all(const string& name) const;
+};
+
+// Grava a mensagem inteira em `fd`. Lança runtime_error em falha de E/S.
+void send_message(int fd, const Message& message);
+// Lê uma mensagem de `fd`. Retorna falso se a conexão fechar antes do
+// cabeçalho; lança runtime_error se a mensagem estiver truncada ou malformada.
+bool receive_message(int fd, Message& message);
+
+// Conecta ao socket Unix em `path`; retorna -1 se não houver servidor.
+int connect_socket(const string& path);
+// Verdadeiro se o processo do outro lado de `fd` é do mesmo usuário
+// (SO_PEERCRED).
+bool peer_is_owner(int fd);
+// $ASM_SOCKET, $XDG_RUNTIME_DIR/asm-compiler.sock ou
+// /tmp/asm-compiler-<uid>/server.sock; o diretório em /tmp é criado com modo
+// 0700. Lança runtime_error se esse diretório for de outro usuário ou estiver
+// aberto aos outros.
+string default_socket_path();
+
+#endif // PROTOCOL_HPP
@@ -0,0 +1,268 @@
+#include "Server.hpp"
+#include "BuildCache.hpp"
+#include "CommandLine.hpp"
+#include "Driver.hpp"
+#include "ObjectFile.hpp"
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <poll.h>
+#include <sched.h>
+#include <sstream>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace
+{
+    constexpr long CLIENT_TIMEOUT_SECONDS = 30;
+
+    // Mesmo formato das mensagens do montador no CLI.
+    string format_diagnostics(const AssemblyOutput &output)
+    {
+        ostringstream text;
+        if (!output.fatal.empty())
+        {
+            text << "Erro fatal durante a compilacao: " << output.fatal << "\n";
+        }
+        else if (!output.errors.empty())
+        {
+            text << "Erros encontrados durante a montagem:\n";
+            for (const auto &err : output.errors)
+                text << "Linha " << err.first << ": " << err.second << "\n";
+        }
+        return text.str();
+    }
+
+    string format_words(const vector<int> &words)
+    {
+        ostringstream text;
+        write_text_object(text, words);
+        return text.str();
+    }
+}
+
+AssemblerServer::AssemblerServer(string socketPath, unsigned workers)
+    : socketPath(std::move(socketPath)), serverDirectory(filesystem::current_path().string()),
+      workerCount(max(1u, workers))
+{
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (this->socketPath.size() >= sizeof(address.sun_path))
+        throw runtime_error("Caminho do socket muito longo: " + this->socketPath);
+    memcpy(address.sun_path, this->socketPath.c_str(), this->socketPath.size() + 1);
+
+    // Um socket nosso que ninguém atende sobrou de um servidor que não terminou
+    // direito. Qualquer outro arquivo no caminho (um .asm digitado por engano,
+    // o socket de outro usuário) fica onde está.
+    struct stat existing;
+    if (lstat(this->socketPath.c_str(), &existing) == 0)
+    {
+        if (!S_ISSOCK(existing.st_mode) || existing.st_uid != getuid())
+            throw runtime_error("O caminho ja existe e nao e um socket deste usuario: " + this->socketPath);
+        int probe = connect_socket(this->socketPath);
+        if (probe >= 0)
+        {
+            close(probe);
+            throw runtime_error("Ja existe um servidor em " + this->socketPath);
+        }
+        unlink(this->socketPath.c_str());
+    }
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0)
+        throw runtime_error(string("Nao foi possivel criar o socket: ") + strerror(errno));
+    // Só o dono pode conectar: o servidor lê e grava arquivos com as permissões dele.
+    mode_t oldMask = umask(077);
+    int bound = bind(listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+    umask(oldMask);
+    if (bound != 0 || listen(listenFd, 128) != 0)
+    {
+        string reason = strerror(errno);
+        close(listenFd);
+        throw runtime_error("Nao foi possivel escutar em " + this->socketPath + ": " + reason);
+    }
+}
+
+AssemblerServer::~AssemblerServer()
+{
+    if (listenFd >= 0)
+    {
+        close(listenFd);
+        unlink(socketPath.c_str());
+    }
+}
+
+void AssemblerServer::run()
+{
+    for (unsigned i = 0; i < workerCount; i++)
+        pool.emplace_back([this]
+                          { worker(); });
+
+    // poll com timeout para perceber stop() (ex: vindo de um sinal) sem depender
+    // de accept ser interrompido.
+    while (!stopping)
+    {
+        pollfd waiting{listenFd, POLLIN, 0};
+        int ready_count = poll(&waiting, 1, 200);
+        if (ready_count <= 0)
+            continue;
+        int client = accept(listenFd, nullptr, nullptr);
+        if (client < 0)
+            continue;
+        // O modo do socket pode ter sido mudado depois do bind: quem conecta
+        // precisa ser o dono do servidor.
+        if (!peer_is_owner(client))
+        {
+            close(client);
+            continue;
+        }
+        // Um cliente parado não prende o worker: a leitura e a escrita
+        // desistem depois de CLIENT_TIMEOUT_SECONDS.
+        timeval timeout{CLIENT_TIMEOUT_SECONDS, 0};
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        lock_guard<mutex> guard(lock);
+        pending.push_back(client);
+        ready.notify_one();
+    }
+
+    {
+        lock_guard<mutex> guard(lock);
+        ready.notify_all();
+    }
+    for (thread &t : pool)
+        t.join();
+    pool.clear();
+}
+
+void AssemblerServer::worker()
+{
+    // Montador do worker, reaproveitado (com reset) por todos os pedidos com texto.
+    MemoryAssembler assembler;
+    // Cada worker tem o seu diretório atual (unshare(CLONE_FS) vale para esta
+    // thread e as que ela criar): um pedido roda no diretório do cliente, com
+    // os caminhos e as mensagens do `compiler` rodando lá, sem mudar o dos
+    // outros workers.
+    bool ownDirectory = unshare(CLONE_FS) == 0;
+    while (true)
+    {
+        int client;
+        {
+            unique_lock<mutex> guard(lock);
+            ready.wait(guard, [this]
+                       { return !pending.empty() || stopping; });
+            // Ao parar, as conexões já aceitas ainda são atendidas.
+            if (pending.empty())
+                return;
+            client = pending.front();
+            pending.pop_front();
+        }
+        handle(client, assembler, ownDirectory);
+        close(client);
+    }
+}
+
+void AssemblerServer::handle(int client, MemoryAssembler &assembler, bool ownDirectory)
+{
+    try
+    {
+        Message request;
+        if (!receive_message(client, request))
+            return;
+        string type = request.get("type");
+        Message response;
+        // Os pedidos que leem e gravam arquivos rodam no diretório do cliente
+        // (sem o campo cwd, no do servidor).
+        bool usesFiles = type == "compile" || (type == "assemble" && !request.find("source"));
+        string cwd = request.get("cwd");
+        string directory = cwd.empty() ? serverDirectory : cwd;
+        if (usesFiles && !(ownDirectory ? chdir(directory.c_str()) == 0 : directory == serverDirectory))
+        {
+            response.add("status", "1");
+            response.add(type == "compile" ? "err" : "diagnostics",
+                         "Nao foi possivel usar o diretorio do cliente: " + directory + "\n");
+        }
+        else if (type == "compile")
+        {
+            response = compile_request(request);
+        }
+        else if (type == "assemble")
+        {
+            response = assemble_request(request, assembler, !cwd.empty());
+        }
+        else if (type == "shutdown")
+        {
+            response.add("status", "0");
+            stop();
+            lock_guard<mutex> guard(lock);
+            ready.notify_all();
+        }
+        else
+        {
+            response.add("status", "1");
+            response.add("err", "Pedido desconhecido: " + type + "\n");
+        }
+        send_message(client, response);
+    }
+    catch (const exception &e)
+    {
+        // Erro de um cliente (mensagem malformada, conexão caída) não derruba o servidor.
+        cerr << "Pedido descartado: " << e.what() << endl;
+    }
+}
+
+Message AssemblerServer::compile_request(const Message &request)
+{
+    ostringstream out;
+    ostringstream err;
+    int status = run_command_line("compiler", request.all("arg"), out, err);
+    Message response;
+    response.add("status", to_string(status));
+    response.add("out", out.str());
+    response.add("err", err.str());
+    return response;
+}
+
+Message AssemblerServer::assemble_request(const Message &request, MemoryAssembler &assembler, bool clientDirectory)
+{
+    Message response;
+    if (const string *source = request.find("source"))
+    {
+        assembler.set_optimize(request.get("optimize") == "1");
+        const AssemblyOutput &output = assembler.assemble(*source);
+        response.add("status", output.ok() ? "0" : "1");
+        response.add("words", output.fatal.empty() ? format_words(output.words) : "");
+        response.add("diagnostics", format_diagnostics(output));
+        return response;
+    }
+
+    // Caminho: monta no lugar, como o CLI, e devolve também as words.
+    CompileOptions options;
+    options.threaded = false; // o pedido já roda numa thread do pool
+    options.logLevel = LogLevel::ERROR;
+    options.optimize = request.get("optimize") == "1";
+    ostringstream diagnostics;
+    // Um caminho relativo só vale junto com o diretório do cliente.
+    string input = request.get("path");
+    if (!clientDirectory && !filesystem::path(input).is_absolute())
+    {
+        response.add("status", "1");
+        response.add("words", "");
+        response.add("diagnostics", "Caminho relativo sem o diretorio do cliente (cwd): " + input + "\n");
+        return response;
+    }
+    CompileResult result = compile_file(input, options, diagnostics);
+    response.add("status", result.ok() ? "0" : "1");
+    // Interrompida por --max-errors a montagem não grava o .o2.
+    bool wroteObjects = !result.fatal && !result.stoppedEarly;
+    response.add("words", wroteObjects ? read_file_contents(change_extension(input, ".o2")) : "");
+    response.add("diagnostics", diagnostics.str());
+    return response;
+}
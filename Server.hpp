@@ -0,0 +1,58 @@
+#ifndef SERVER_HPP
+#define SERVER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "MemoryAssembler.hpp"
+#include "Protocol.hpp"
+
+using namespace std;
+
+// Servidor do `compiler --serve`: escuta um socket Unix e atende os pedidos
+// descritos em Protocol.hpp, um por conexão. A thread de run() aceita as
+// conexões e as entrega a um pool de `workers` threads. Cada worker tem o seu
+// MemoryAssembler, reaproveitado entre os pedidos com o texto do fonte; os
+// pedidos com caminhos usam compile_file. Pedidos concorrentes não
+// compartilham estado; cada worker tem o seu diretório atual, e um pedido
+// roda no diretório do cliente. Só são atendidas conexões de processos do mesmo
+// usuário (SO_PEERCRED), e um cliente que não envia nem lê por 30 s é
+// desconectado.
+class AssemblerServer {
+public:
+    // Cria e escuta o socket. Um socket abandonado do mesmo usuário é
+    // removido; lança runtime_error se já houver um servidor respondendo nele
+    // ou se o caminho for outro tipo de arquivo ou de outro usuário.
+    AssemblerServer(string socketPath, unsigned workers);
+    ~AssemblerServer();
+    AssemblerServer(const AssemblerServer&) = delete;
+    AssemblerServer& operator=(const AssemblerServer&) = delete;
+
+    // Aceita conexões até stop() ou um pedido "shutdown"; espera os pedidos em
+    // andamento antes de retornar.
+    void run();
+    // Pode ser chamado de outra thread ou de um tratador de sinal.
+    void stop() { stopping = true; }
+
+private:
+    void worker();
+    void handle(int client, MemoryAssembler& assembler, bool ownDirectory);
+    Message compile_request(const Message& request);
+    Message assemble_request(const Message& request, MemoryAssembler& assembler, bool clientDirectory);
+
+    string socketPath;
+    string serverDirectory; // diretório dos pedidos sem cwd
+    unsigned workerCount;
+    int listenFd = -1;
+    atomic<bool> stopping{false};
+    deque<int> pending;
+    mutex lock;
+    condition_variable ready;
+    vector<thread> pool;
+};
+
+#endif // SERVER_HPP
@@ -0,0 +1,369 @@
+#include "Simulator.hpp"
+#include "OpTable.hpp"
+#include <array>
+#include <cctype>
+#include <chrono>
+#include <charconv>
+#include <climits>
+#include <stdexcept>
+#include <streambuf>
+
+using namespace std;
+
+namespace
+{
+    // Operações internas. 1..14 são os próprios opcodes da máquina; as demais
+    // são estados do pré-decodificador.
+    enum Op : uint8_t
+    {
+        OP_DECODE = 0, // entrada invalidada: decodifica de novo antes de executar
+        OP_ADD = 1,
+        OP_SUB,
+        OP_MULT,
+        OP_DIV,
+        OP_JMP,
+        OP_JMPN,
+        OP_JMPP,
+        OP_JMPZ,
+        OP_COPY,
+        OP_LOAD,
+        OP_STORE,
+        OP_INPUT,
+        OP_OUTPUT,
+        OP_STOP,
+        OP_BAD_OPCODE,
+        OP_BAD_OPERAND,
+        OP_TRUNCATED,
+        OP_END,
+        OP_COUNT
+    };
+
+    // Tamanho de cada instrução (em words) tirado da OPTAB; 0 = opcode inválido.
+    constexpr array<uint8_t, OP_STOP + 1> build_sizes()
+    {
+        array<uint8_t, OP_STOP + 1> sizes{};
+        for (const OpInfo &info : OPTAB)
+        {
+            if (info.kind == OpKind::INSTRUCTION)
+                sizes[info.opcode] = static_cast<uint8_t>(info.size);
+        }
+        return sizes;
+    }
+
+    constexpr array<uint8_t, OP_STOP + 1> SIZES = build_sizes();
+    static_assert(SIZES[OP_STOP] == 1 && SIZES[OP_COPY] == 3, "OPTAB e o simulador divergem");
+
+    // Leitura de inteiros (INPUT) direto do streambuf, sem o custo de operator>>.
+    class InputReader
+    {
+    public:
+        explicit InputReader(istream &in) : buffer(in.rdbuf()) {}
+
+        bool next(int32_t &value)
+        {
+            int c = buffer->sgetc();
+            while (c != EOF && isspace(c))
+                c = buffer->snextc();
+            bool negative = false;
+            if (c == '-' || c == '+')
+            {
+                negative = c == '-';
+                c = buffer->snextc();
+            }
+            if (c == EOF || !isdigit(c))
+                return false;
+            int64_t parsed = 0;
+            while (c != EOF && isdigit(c))
+            {
+                parsed = parsed * 10 + (c - '0');
+                if (parsed > static_cast<int64_t>(INT32_MAX) + 1)
+                    return false;
+                c = buffer->snextc();
+            }
+            parsed = negative ? -parsed : parsed;
+            if (parsed > INT32_MAX)
+                return false;
+            value = static_cast<int32_t>(parsed);
+            return true;
+        }
+
+    private:
+        streambuf *buffer;
+    };
+
+    // Saída (OUTPUT) acumulada em blocos; o destrutor grava o que sobrou,
+    // inclusive quando a execução termina com erro.
+    class OutputWriter
+    {
+    public:
+        explicit OutputWriter(ostream &out) : out(out) { text.reserve(limit + 16); }
+        ~OutputWriter() { flush(); }
+
+        void write(int32_t value)
+        {
+            char digits[16];
+            char *end = to_chars(digits, digits + sizeof(digits), value).ptr;
+            text.append(digits, end);
+            text.push_back('\n');
+            if (text.size() >= limit)
+                flush();
+        }
+
+        void flush()
+        {
+            out.write(text.data(), static_cast<streamsize>(text.size()));
+            out.flush();
+            text.clear();
+        }
+
+    private:
+        static constexpr size_t limit = 64 * 1024;
+        ostream &out;
+        string text;
+    };
+
+    int32_t wrap(int64_t value)
+    {
+        return static_cast<int32_t>(static_cast<uint32_t>(value));
+    }
+}
+
+Simulator::Simulator(vector<int> image, int entryPoint)
+    : mem(image.begin(), image.end()), code(image.size() + 1), pc(entryPoint)
+{
+    if (entryPoint < 0 || static_cast<size_t>(entryPoint) >= mem.size())
+        throw runtime_error("Ponto de entrada fora da memoria: " + to_string(entryPoint));
+    // Pré-decodifica todas as posições: um salto pode cair em qualquer uma.
+    for (size_t address = 0; address < code.size(); address++)
+        code[address] = decode(static_cast<int>(address));
+}
+
+Simulator::Decoded Simulator::decode(int address) const
+{
+    const int size = static_cast<int>(mem.size());
+    if (address >= size)
+        return {OP_END, 0, 0};
+    int32_t opcode = mem[address];
+    if (opcode < OP_ADD || opcode > OP_STOP)
+        return {OP_BAD_OPCODE, opcode, 0};
+    int length = SIZES[opcode];
+    if (address + length > size)
+        return {OP_TRUNCATED, 0, 0};
+
+    Decoded decoded{static_cast<uint8_t>(opcode), 0, 0};
+    for (int i = 1; i < length; i++)
+    {
+        int32_t operand = mem[address + i];
+        // Saltos e acessos fora da memória viram erro só se forem executados.
+        if (operand < 0 || operand >= size)
+            return {OP_BAD_OPERAND, operand, 0};
+        (i == 1 ? decoded.a : decoded.b) = operand;
+    }
+    return decoded;
+}
+
+void Simulator::fault(int address, const string &message) const
+{
+    throw runtime_error("Erro de execucao no endereco " + to_string(address) + ": " + message);
+}
+
+SimulationResult Simulator::run(istream &in, ostream &out, uint64_t maxSteps)
+{
+    SimulationResult result;
+    InputReader input(in);
+    OutputWriter output(out);
+    const uint64_t limit = maxSteps == 0 ? UINT64_MAX : maxSteps;
+    uint64_t steps = 0;
+
+    // Estado em variáveis locais: como a memória é um array de int32, o
+    // compilador não poderia manter acc/pc em registradores se fossem membros.
+    int32_t *m = mem.data();
+    Decoded *c = code.data();
+    int32_t a = acc;
+    int p = pc;
+    const Decoded *current = nullptr;
+    auto start = chrono::steady_clock::now();
+
+// Uma escrita em `address` muda as instruções que começam em address-2..address
+// (o tamanho máximo é 3 words): elas voltam para OP_DECODE.
+#define SIM_INVALIDATE(address)                       \
+    do {                                              \
+        int at_ = (address);                          \
+        c[at_].op = OP_DECODE;                        \
+        if (at_ >= 1) c[at_ - 1].op = OP_DECODE;      \
+        if (at_ >= 2) c[at_ - 2].op = OP_DECODE;      \
+    } while (0)
+#define SIM_FAULT(message)     \
+    do {                       \
+        acc = a;               \
+        pc = p;                \
+        result.instructions = steps; \
+        fault(p, message);     \
+    } while (0)
+
+#if SIM_COMPUTED_GOTO
+    static const void *const handlers[OP_COUNT] = {
+        &&op_decode, &&op_add, &&op_sub, &&op_mult, &&op_div, &&op_jmp, &&op_jmpn, &&op_jmpp, &&op_jmpz,
+        &&op_copy, &&op_load, &&op_store, &&op_input, &&op_output, &&op_stop,
+        &&op_bad_opcode, &&op_bad_operand, &&op_truncated, &&op_end};
+#define SIM_OP(label, name) label:
+#define SIM_FETCH()                  \
+    do {                             \
+        current = &c[p];             \
+        goto *handlers[current->op]; \
+    } while (0)
+#define SIM_NEXT()                   \
+    do {                             \
+        if (++steps == limit)        \
+            goto out_of_steps;       \
+        SIM_FETCH();                 \
+    } while (0)
+    SIM_FETCH();
+#else
+#define SIM_OP(label, name) case name:
+#define SIM_FETCH() continue
+#define SIM_NEXT()             \
+    {                          \
+        if (++steps == limit)  \
+            goto out_of_steps; \
+        continue;              \
+    }
+    for (;;)
+    {
+        current = &c[p];
+        switch (current->op)
+        {
+#endif
+
+    SIM_OP(op_decode, OP_DECODE)
+    {
+        c[p] = decode(p);
+        SIM_FETCH();
+    }
+    SIM_OP(op_add, OP_ADD)
+    {
+        a = wrap(static_cast<int64_t>(a) + m[current->a]);
+        p += 2;
+        SIM_NEXT();
+    }
+    SIM_OP(op_sub, OP_SUB)
+    {
+        a = wrap(static_cast<int64_t>(a) - m[current->a]);
+        p += 2;
+        SIM_NEXT();
+    }
+    SIM_OP(op_mult, OP_MULT)
+    {
+        a = wrap(static_cast<int64_t>(a) * m[current->a]);
+        p += 2;
+        SIM_NEXT();
+    }
+    SIM_OP(op_div, OP_DIV)
+    {
+        int32_t divisor = m[current->a];
+        if (divisor == 0)
+            SIM_FAULT("divisao por zero");
+        a = wrap(static_cast<int64_t>(a) / divisor);
+        p += 2;
+        SIM_NEXT();
+    }
+    SIM_OP(op_jmp, OP_JMP)
+    {
+        p = current->a;
+        SIM_NEXT();
+    }
+    SIM_OP(op_jmpn, OP_JMPN)
+    {
+        p = a < 0 ? current->a : p + 2;
+        SIM_NEXT();
+    }
+    SIM_OP(op_jmpp, OP_JMPP)
+    {
+        p = a > 0 ? current->a : p + 2;
+        SIM_NEXT();
+    }
+    SIM_OP(op_jmpz, OP_JMPZ)
+    {
+        p = a == 0 ? current->a : p + 2;
+        SIM_NEXT();
+    }
+    SIM_OP(op_copy, OP_COPY)
+    {
+        m[current->b] = m[current->a];
+        SIM_INVALIDATE(current->b);
+        p += 3;
+        SIM_NEXT();
+    }
+    SIM_OP(op_load, OP_LOAD)
+    {
+        a = m[current->a];
+        p += 2;
+        SIM_NEXT();
+    }
+    SIM_OP(op_store, OP_STORE)
+    {
+        m[current->a] = a;
+        SIM_INVALIDATE(current->a);
+        p += 2;
+        SIM_NEXT();
+    }
+    SIM_OP(op_input, OP_INPUT)
+    {
+        int32_t value;
+        if (!input.next(value))
+            SIM_FAULT("entrada esgotada ou invalida");
+        m[current->a] = value;
+        SIM_INVALIDATE(current->a);
+        p += 2;
+        SIM_NEXT();
+    }
+    SIM_OP(op_output, OP_OUTPUT)
+    {
+        output.write(m[current->a]);
+        p += 2;
+        SIM_NEXT();
+    }
+    SIM_OP(op_stop, OP_STOP)
+    {
+        steps++;
+        result.halted = true;
+        goto finished;
+    }
+    SIM_OP(op_bad_opcode, OP_BAD_OPCODE)
+    {
+        SIM_FAULT("opcode invalido " + to_string(current->a));
+    }
+    SIM_OP(op_bad_operand, OP_BAD_OPERAND)
+    {
+        SIM_FAULT("operando fora da memoria: " + to_string(current->a));
+    }
+    SIM_OP(op_truncated, OP_TRUNCATED)
+    {
+        SIM_FAULT("instrucao incompleta no fim da memoria");
+    }
+    SIM_OP(op_end, OP_END)
+    {
+        SIM_FAULT("execucao passou do fim da memoria sem STOP");
+    }
+
+#if !SIM_COMPUTED_GOTO
+        default:
+            SIM_FAULT("operacao interna invalida");
+        }
+    }
+#endif
+
+out_of_steps:
+finished:
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    result.instructions = steps;
+    acc = a;
+    pc = p;
+    return result;
+
+#undef SIM_INVALIDATE
+#undef SIM_FAULT
+#undef SIM_OP
+#undef SIM_FETCH
+#undef SIM_NEXT
+}
@@ -0,0 +1,68 @@
+#ifndef SIMULATOR_HPP
+#define SIMULATOR_HPP
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Com GCC/Clang o laço de execução usa computed goto (cada handler salta
+// direto para o próximo); nos demais compiladores, ou com
+// -DSIM_SWITCH_DISPATCH, usa um switch.
+#if defined(__GNUC__) && !defined(SIM_SWITCH_DISPATCH)
+#define SIM_COMPUTED_GOTO 1
+#else
+#define SIM_COMPUTED_GOTO 0
+#endif
+
+// Resultado de uma execução.
+struct SimulationResult {
+    uint64_t instructions = 0; // instruções executadas
+    double seconds = 0;        // tempo de parede da execução
+    bool halted = false;       // terminou em STOP (false: limite de passos)
+
+    double instructions_per_second() const { return seconds > 0 ? static_cast<double>(instructions) / seconds : 0; }
+};
+
+// Executa imagens .o2 da máquina hipotética (ACC + memória de words).
+// O código é pré-decodificado uma vez num vetor paralelo à memória, com os
+// operandos já validados; uma escrita na memória invalida as entradas que
+// leem aquela word, que são decodificadas de novo se forem executadas (código
+// automodificável continua correto). Erros de execução lançam runtime_error.
+class Simulator {
+public:
+    explicit Simulator(vector<int> image, int entryPoint = 0);
+
+    // Executa até STOP ou até `maxSteps` instruções (0 = sem limite). INPUT lê
+    // inteiros de `in` e OUTPUT grava um inteiro por linha em `out`, ambos
+    // através de buffers próprios.
+    SimulationResult run(istream& in, ostream& out, uint64_t maxSteps = 0);
+
+    const vector<int32_t>& memory() const { return mem; }
+    int32_t accumulator() const { return acc; }
+    int program_counter() const { return pc; }
+
+private:
+    // Instrução decodificada: operação interna e operandos já resolvidos
+    // (endereços de memória ou destino do salto).
+    struct Decoded {
+        uint8_t op;
+        int32_t a;
+        int32_t b;
+    };
+
+    Decoded decode(int address) const;
+    [[noreturn]] void fault(int address, const string& message) const;
+
+    vector<int32_t> mem;
+    // code[i] é a instrução que começa em mem[i]; code[mem.size()] é uma
+    // sentinela para quem passa do fim da memória.
+    vector<Decoded> code;
+    int32_t acc = 0;
+    int pc = 0;
+};
+
+#endif // SIMULATOR_HPP
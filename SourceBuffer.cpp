@@ -0,0 +1,98 @@
+#include "SourceBuffer.hpp"
+#include "TextScan.hpp"
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+SourceBuffer::SourceBuffer(const string &filename, bool snapshot)
+{
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw runtime_error("Nao foi possivel abrir o arquivo de entrada: " + filename);
+    }
+
+    struct stat info;
+    if (!snapshot && fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+    {
+        void *mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED)
+        {
+            mapping = mapped;
+            data = static_cast<char *>(mapped);
+            size = static_cast<size_t>(info.st_size);
+            madvise(mapped, size, MADV_SEQUENTIAL);
+        }
+    }
+    if (!mapping)
+    {
+        // Pipes e afins (ou snapshot): uma única leitura em bloco para a memória.
+        read_all(fd);
+    }
+    close(fd);
+    build_line_index();
+}
+
+SourceBuffer::~SourceBuffer()
+{
+    if (mapping)
+    {
+        munmap(mapping, size);
+    }
+}
+
+void SourceBuffer::read_all(int fd)
+{
+    char chunk[1 << 16];
+    while (true)
+    {
+        ssize_t n = read(fd, chunk, sizeof(chunk));
+        if (n < 0)
+        {
+            throw runtime_error("Erro ao ler o arquivo de entrada.");
+        }
+        if (n == 0)
+            break;
+        fallback.append(chunk, static_cast<size_t>(n));
+    }
+    data = fallback.data();
+    size = fallback.size();
+}
+
+void SourceBuffer::build_line_index()
+{
+    // memchr é vetorizado pela libc: a busca por '\n' percorre o buffer em blocos.
+    lineStarts.clear();
+    const char *begin = data;
+    const char *end = data + size;
+    const char *cur = begin;
+    while (cur < end)
+    {
+        lineStarts.push_back(static_cast<size_t>(cur - begin));
+        const char *newline = static_cast<const char *>(memchr(cur, '\n', static_cast<size_t>(end - cur)));
+        if (!newline)
+            break;
+        cur = newline + 1;
+    }
+}
+
+string_view SourceBuffer::fold_upper_in_place()
+{
+    fold_upper(data, size);
+    return text();
+}
+
+string_view SourceBuffer::line(size_t index) const
+{
+    size_t start = lineStarts.at(index);
+    size_t stop = index + 1 < lineStarts.size() ? lineStarts[index + 1] - 1 : size;
+    // A última linha pode terminar sem '\n'.
+    if (stop > start && stop == size && data[stop - 1] == '\n')
+        stop--;
+    return string_view(data + start, stop - start);
+}
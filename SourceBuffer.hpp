@@ -0,0 +1,48 @@
+#ifndef SOURCE_BUFFER_HPP
+#define SOURCE_BUFFER_HPP
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+// Arquivo de entrada inteiro em memória: mapeado com mmap quando possível ou
+// lido de uma vez (pipes, /dev/stdin, sistemas sem mmap). Um índice com o
+// início de cada linha é montado numa única varredura, o que dá acesso
+// aleatório às linhas (ex: para mensagens de erro) sem reler o arquivo.
+class SourceBuffer {
+public:
+    // Com `snapshot` o arquivo é sempre lido para a memória: o conteúdo não
+    // muda se o arquivo for alterado depois (o mapeamento privado não garante
+    // isso para as páginas ainda não copiadas).
+    explicit SourceBuffer(const string& filename, bool snapshot = false);
+    ~SourceBuffer();
+    SourceBuffer(const SourceBuffer&) = delete;
+    SourceBuffer& operator=(const SourceBuffer&) = delete;
+
+    // Número de linhas com a mesma semântica de getline (um '\n' final não
+    // cria uma linha vazia extra).
+    size_t lineCount() const { return lineStarts.size(); }
+    // Linha pelo índice (0-based), sem o '\n'.
+    string_view line(size_t index) const;
+    // Linha pelo número usado nas mensagens de erro (1-based).
+    string_view lineAt(int lineNumber) const { return line(static_cast<size_t>(lineNumber - 1)); }
+    string_view text() const { return string_view(data, size); }
+    // Converte o texto para maiúsculas no próprio buffer (fold_upper). O
+    // mapeamento é privado: o arquivo em disco não muda.
+    string_view fold_upper_in_place();
+
+private:
+    void read_all(int fd);
+    void build_line_index();
+
+    char* data = nullptr;
+    size_t size = 0;
+    void* mapping = nullptr;
+    string fallback;
+    vector<size_t> lineStarts;
+};
+
+#endif // SOURCE_BUFFER_HPP
@@ -0,0 +1,139 @@
+#include "Stats.hpp"
+#include <ctime>
+#include <iomanip>
+
+using namespace std;
+
+double thread_cpu_seconds()
+{
+    timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0)
+        return 0;
+    return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) * 1e-9;
+}
+
+void PhaseClock::stop()
+{
+    if (!target)
+        return;
+    target->wall += chrono::duration<double>(chrono::steady_clock::now() - wallStart).count();
+    target->cpu += thread_cpu_seconds() - cpuStart;
+    target->heap += thread_allocations() - heapStart;
+    target = nullptr;
+}
+
+namespace
+{
+    // As colunas de alocações só aparecem quando elas são contadas
+    // (MEMORY_COUNT_ALLOCATIONS, em Memory.hpp).
+    void print_phase(ostream &out, const char *name, const PhaseTime &phase)
+    {
+        out << "  " << left << setw(18) << name << right << fixed << setprecision(3)
+            << setw(10) << phase.wall * 1e3 << " ms wall" << setw(10) << phase.cpu * 1e3 << " ms cpu";
+        if (allocation_counting)
+            out << setw(12) << phase.heap.bytes << " bytes" << setw(8) << phase.heap.count << " aloc.";
+        out << "\n";
+    }
+
+    void print_counter(ostream &out, const char *name, size_t value)
+    {
+        out << "  " << left << setw(24) << name << right << setw(12) << value << "\n";
+    }
+
+    void json_phase(ostream &out, const char *name, const PhaseTime &phase)
+    {
+        out << "\"" << name << "\":{\"wall_ms\":" << phase.wall * 1e3 << ",\"cpu_ms\":" << phase.cpu * 1e3;
+        if (allocation_counting)
+            out << ",\"heap_bytes\":" << phase.heap.bytes << ",\"heap_allocations\":" << phase.heap.count;
+        out << "}";
+    }
+
+    void json_string(ostream &out, const string &text)
+    {
+        out << '"';
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+                out << '\\' << c;
+            else if (static_cast<unsigned char>(c) < 0x20)
+                out << "\\u" << hex << setw(4) << setfill('0') << static_cast<int>(c) << dec << setfill(' ');
+            else
+                out << c;
+        }
+        out << '"';
+    }
+}
+
+void CompileStats::print(ostream &out) const
+{
+    ios::fmtflags flags = out.flags();
+    out << (allocation_counting ? "Tempos e alocacoes no heap por fase:\n" : "Tempos por fase:\n");
+    print_phase(out, "pre-processamento", preprocess);
+    print_phase(out, "tokenizacao", tokenize);
+    print_phase(out, "codificacao", encode);
+    print_phase(out, "gravacao", write);
+    print_phase(out, "total", total);
+    out << "Contadores:\n";
+    print_counter(out, "linhas de entrada", sourceLines);
+    print_counter(out, "linhas expandidas", expandedLines);
+    print_counter(out, "expansoes de macro", macroExpansions);
+    print_counter(out, "linhas montadas", assembledLines);
+    print_counter(out, "tokens", tokens);
+    print_counter(out, "simbolos", symbols);
+    print_counter(out, "referencias adiante", forwardReferences);
+    print_counter(out, "cadeias de pendencias", fixupChains);
+    print_counter(out, "maior cadeia", longestFixupChain);
+    print_counter(out, "words de codigo", objectWords);
+    print_counter(out, "maior linha (bytes)", longestLine);
+    print_counter(out, "pico pilha de macros", peakMacroDepth);
+    print_counter(out, "pico lotes na fila", peakQueuedBatches);
+    print_counter(out, "arena pre-proc. (bytes)", arenaBytes);
+    print_counter(out, "erros", errors);
+    print_counter(out, "instrucoes removidas", removedInstructions);
+    print_counter(out, "words removidas", removedWords);
+    print_counter(out, "saltos encurtados", threadedJumps);
+    print_counter(out, "acertos no cache", cacheHits);
+    out.flags(flags);
+}
+
+void CompileStats::print_json(ostream &out, const string &input, bool fatal) const
+{
+    ios::fmtflags flags = out.flags();
+    streamsize precision = out.precision();
+    out << fixed << setprecision(3);
+    out << "{\"input\":";
+    json_string(out, input);
+    out << ",\"fatal\":" << (fatal ? "true" : "false") << ",\"phases\":{";
+    json_phase(out, "preprocess", preprocess);
+    out << ",";
+    json_phase(out, "tokenize", tokenize);
+    out << ",";
+    json_phase(out, "encode", encode);
+    out << ",";
+    json_phase(out, "write", write);
+    out << ",";
+    json_phase(out, "total", total);
+    out << "},\"counters\":{"
+        << "\"source_lines\":" << sourceLines
+        << ",\"expanded_lines\":" << expandedLines
+        << ",\"macro_expansions\":" << macroExpansions
+        << ",\"assembled_lines\":" << assembledLines
+        << ",\"tokens\":" << tokens
+        << ",\"symbols\":" << symbols
+        << ",\"forward_references\":" << forwardReferences
+        << ",\"fixup_chains\":" << fixupChains
+        << ",\"longest_fixup_chain\":" << longestFixupChain
+        << ",\"object_words\":" << objectWords
+        << ",\"longest_line_bytes\":" << longestLine
+        << ",\"peak_macro_depth\":" << peakMacroDepth
+        << ",\"peak_queued_batches\":" << peakQueuedBatches
+        << ",\"arena_bytes\":" << arenaBytes
+        << ",\"errors\":" << errors
+        << ",\"removed_instructions\":" << removedInstructions
+        << ",\"removed_words\":" << removedWords
+        << ",\"threaded_jumps\":" << threadedJumps
+        << ",\"cache_hits\":" << cacheHits
+        << "}}";
+    out.flags(flags);
+    out.precision(precision);
+}
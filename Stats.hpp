@@ -0,0 +1,100 @@
+#ifndef STATS_HPP
+#define STATS_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include "Memory.hpp"
+
+using namespace std;
+
+// Tempo gasto numa fase: relógio de parede e CPU da(s) thread(s) que a
+// executaram, e as alocações que essas threads fizeram no heap durante a fase.
+struct PhaseTime {
+    double wall = 0; // segundos
+    double cpu = 0;  // segundos
+    AllocationCount heap;
+
+    PhaseTime& operator+=(const PhaseTime& other)
+    {
+        wall += other.wall;
+        cpu += other.cpu;
+        heap += other.heap;
+        return *this;
+    }
+};
+
+// Tempo de CPU consumido pela thread atual (CLOCK_THREAD_CPUTIME_ID).
+double thread_cpu_seconds();
+
+// Mede uma fase do construtor até stop() (ou o destrutor) e soma em `target`;
+// com `target` nulo (sem --stats) não lê relógio nenhum. Precisa rodar inteira
+// na mesma thread, pois o tempo de CPU e as alocações são os da thread.
+class PhaseClock {
+public:
+    explicit PhaseClock(PhaseTime* target) : target(target)
+    {
+        if (target)
+        {
+            wallStart = chrono::steady_clock::now();
+            cpuStart = thread_cpu_seconds();
+            heapStart = thread_allocations();
+        }
+    }
+    ~PhaseClock() { stop(); }
+    void stop();
+
+private:
+    PhaseTime* target;
+    chrono::steady_clock::time_point wallStart;
+    double cpuStart = 0;
+    AllocationCount heapStart;
+};
+
+// Relatório do --stats de uma compilação. As fases de tokenização e
+// codificação são intercaladas linha a linha: o tempo de parede de cada uma é
+// somado por linha e o tempo de CPU da passagem é dividido entre elas na mesma
+// proporção. Na codificação entra também a resolução das pendências. Com
+// --split as linhas são montadas em várias threads e esses tempos somam o de
+// todas elas. As alocações de cada fase são contadas do mesmo jeito, sem
+// proporção: as da tokenização são medidas em volta do scanner.
+struct CompileStats {
+    PhaseTime preprocess;
+    PhaseTime tokenize;
+    PhaseTime encode;
+    PhaseTime write;
+    PhaseTime total;
+
+    // Pré-processador
+    size_t sourceLines = 0;
+    size_t expandedLines = 0;       // linhas entregues ao montador
+    size_t macroExpansions = 0;     // chamadas de macro (inclusive aninhadas)
+    size_t peakMacroDepth = 0;      // maior pilha de expansão
+    size_t peakQueuedBatches = 0;   // maior nº de lotes na fila entre as threads
+    size_t arenaBytes = 0;          // bytes entregues pela arena do pré-processador
+
+    // Montador
+    size_t assembledLines = 0;
+    size_t tokens = 0;
+    size_t symbols = 0;
+    size_t forwardReferences = 0;   // pendências resolvidas em lote
+    size_t fixupChains = 0;         // símbolos com pelo menos uma pendência
+    size_t longestFixupChain = 0;
+    size_t longestLine = 0;         // bytes
+    size_t objectWords = 0;
+    size_t errors = 0;
+
+    // Otimizador (-O)
+    size_t removedInstructions = 0;
+    size_t removedWords = 0;
+    size_t threadedJumps = 0;
+
+    // Cache de compilação
+    size_t cacheHits = 0;           // arquivos restaurados sem montar
+
+    void print(ostream& out) const;
+    void print_json(ostream& out, const string& input, bool fatal) const;
+};
+
+#endif // STATS_HPP
@@ -0,0 +1,102 @@
+#include "SymbolTable.hpp"
+#include <algorithm>
+
+using namespace std;
+
+SymbolTable::SymbolTable() : nameOffsets(1, 0), slots(64, -1)
+{
+}
+
+uint32_t SymbolTable::hash(string_view name)
+{
+    // FNV-1a
+    uint32_t h = 2166136261u;
+    for (char c : name)
+    {
+        h ^= static_cast<unsigned char>(c);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+string_view SymbolTable::name(int id) const
+{
+    return string_view(names).substr(nameOffsets[id], nameOffsets[id + 1] - nameOffsets[id]);
+}
+
+// Retorna o slot onde o nome está ou o primeiro slot vazio da sua sequência.
+size_t SymbolTable::probe(string_view key, uint32_t h) const
+{
+    size_t mask = slots.size() - 1;
+    size_t slot = h & mask;
+    while (true)
+    {
+        int32_t id = slots[slot];
+        if (id < 0 || (hashes[id] == h && name(id) == key))
+            return slot;
+        slot = (slot + 1) & mask;
+    }
+}
+
+int SymbolTable::find(string_view key) const
+{
+    return slots[probe(key, hash(key))];
+}
+
+int SymbolTable::intern(string_view key)
+{
+    uint32_t h = hash(key);
+    size_t slot = probe(key, h);
+    if (slots[slot] >= 0)
+        return slots[slot];
+
+    int id = static_cast<int>(items.size());
+    items.emplace_back();
+    hashes.push_back(h);
+    names.append(key);
+    nameOffsets.push_back(static_cast<uint32_t>(names.size()));
+    slots[slot] = id;
+
+    // Mantém a ocupação abaixo de 50% para sondagens curtas.
+    if (items.size() * 2 > slots.size())
+        grow();
+    return id;
+}
+
+void SymbolTable::grow()
+{
+    slots.assign(slots.size() * 2, -1);
+    size_t mask = slots.size() - 1;
+    for (size_t id = 0; id < items.size(); id++)
+    {
+        size_t slot = hashes[id] & mask;
+        while (slots[slot] >= 0)
+            slot = (slot + 1) & mask;
+        slots[slot] = static_cast<int32_t>(id);
+    }
+}
+
+void SymbolTable::clear()
+{
+    // Índice muito maior que o número de símbolos (ex: um programa grande
+    // seguido de trechos pequenos): limpa só os slots ocupados.
+    if (items.size() * 8 < slots.size())
+    {
+        size_t mask = slots.size() - 1;
+        for (size_t id = 0; id < items.size(); id++)
+        {
+            size_t slot = hashes[id] & mask;
+            while (slots[slot] != static_cast<int32_t>(id))
+                slot = (slot + 1) & mask;
+            slots[slot] = -1;
+        }
+    }
+    else
+    {
+        fill(slots.begin(), slots.end(), -1);
+    }
+    items.clear();
+    names.clear();
+    nameOffsets.assign(1, 0);
+    hashes.clear();
+}
@@ -0,0 +1,56 @@
+#ifndef SYMBOL_TABLE_HPP
+#define SYMBOL_TABLE_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+// Item da Tabela de Símbolos.
+struct SymbolItem {
+    int address = 0;
+    bool isDefined = false;
+    // Última pendência do símbolo (cabeça da lista encadeada do .o1); -1 se não houver.
+    int pendingListHead = -1;
+    bool isExtern = false;  // EXTERN: definido em outro módulo (resolvido pelo ligador)
+    bool isPublic = false;  // PUBLIC: vai para a tabela de definições do objeto
+};
+
+// Tabela de Símbolos com internamento: cada nome vira um ID denso (0, 1, 2...)
+// na primeira vez que aparece. Os itens ficam num vetor contíguo indexado pelo
+// ID e a busca por nome usa endereçamento aberto (sondagem linear) sobre um
+// vetor de IDs, sem nós alocados separadamente.
+class SymbolTable {
+public:
+    SymbolTable();
+
+    // Retorna o ID do nome, criando um item novo (não definido) se necessário.
+    int intern(string_view name);
+    // Retorna o ID do nome ou -1 se ele nunca apareceu.
+    int find(string_view name) const;
+
+    SymbolItem& operator[](int id) { return items[id]; }
+    const SymbolItem& operator[](int id) const { return items[id]; }
+    // A view é invalidada quando novos nomes são internados.
+    string_view name(int id) const;
+    size_t size() const { return items.size(); }
+    // Limpa a tabela mantendo a capacidade alocada.
+    void clear();
+
+private:
+    static uint32_t hash(string_view name);
+    size_t probe(string_view name, uint32_t h) const;
+    void grow();
+
+    vector<SymbolItem> items;
+    // Nomes concatenados; o nome do ID i fica em [nameOffsets[i], nameOffsets[i+1]).
+    string names;
+    vector<uint32_t> nameOffsets;
+    vector<uint32_t> hashes;
+    // Slots do índice: ID do símbolo ou -1 (vazio). Tamanho sempre potência de 2.
+    vector<int32_t> slots;
+};
+
+#endif // SYMBOL_TABLE_HPP
@@ -0,0 +1,292 @@
+#include "TextScan.hpp"
+#include <algorithm>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__) && defined(__SSE2__) && !defined(TEXTSCAN_SCALAR)
+#define TEXTSCAN_X86 1
+#include <immintrin.h>
+#else
+#define TEXTSCAN_X86 0
+#endif
+
+using namespace std;
+
+namespace
+{
+    // Mesmo conjunto de isspace no locale "C": ' ' e '\t'..'\r'.
+    bool is_space(unsigned char c)
+    {
+        return c == ' ' || (c >= '\t' && c <= '\r');
+    }
+
+    void fold_tail(char *text, size_t i, size_t size)
+    {
+        for (; i < size; i++)
+        {
+            if (text[i] >= 'a' && text[i] <= 'z')
+                text[i] = static_cast<char>(text[i] - ('a' - 'A'));
+        }
+    }
+
+    LineInfo make_line(string_view text, size_t begin, size_t end, size_t firstNonSpace, size_t firstSemicolon)
+    {
+        LineInfo info;
+        info.begin = begin;
+        info.length = static_cast<uint32_t>(end - begin);
+        info.codeLength = firstSemicolon == string_view::npos ? info.length : static_cast<uint32_t>(firstSemicolon - begin);
+        if (firstNonSpace == string_view::npos)
+            info.kind = LineKind::BLANK;
+        else if (text[firstNonSpace] == ';')
+            info.kind = LineKind::COMMENT;
+        else
+            info.kind = LineKind::CODE;
+        return info;
+    }
+
+#if TEXTSCAN_X86
+    // Bits de um bloco de 64 bytes (bit i = byte i).
+    struct BlockMasks {
+        uint64_t newline;
+        uint64_t semicolon;
+        uint64_t nonSpace;
+    };
+
+    // Aplica `masks` a cada bloco de 64 bytes (o último é copiado para um bloco
+    // completado com zeros) e monta as linhas a partir dos bits.
+    template <typename Masks>
+    __attribute__((always_inline)) inline void scan_blocks(string_view text, vector<LineInfo> &lines, Masks masks)
+    {
+        lines.clear();
+        const size_t n = text.size();
+        size_t lineStart = 0;
+        size_t firstNonSpace = string_view::npos;
+        size_t firstSemicolon = string_view::npos;
+        for (size_t offset = 0; offset < n; offset += 64)
+        {
+            BlockMasks block;
+            size_t valid = min<size_t>(64, n - offset);
+            if (valid == 64)
+            {
+                block = masks(text.data() + offset);
+            }
+            else
+            {
+                alignas(64) char padded[64] = {};
+                memcpy(padded, text.data() + offset, valid);
+                block = masks(padded);
+                block.nonSpace &= (uint64_t(1) << valid) - 1;
+            }
+
+            // Cada '\n' do bloco fecha uma linha; entre dois deles, o primeiro
+            // não-espaço e o primeiro ';' (se a linha ainda não tem) saem da
+            // máscara do trecho.
+            uint64_t newlines = block.newline;
+            size_t cursor = 0;
+            while (true)
+            {
+                size_t end = newlines ? static_cast<size_t>(__builtin_ctzll(newlines)) : 64;
+                uint64_t range = (end == 64 ? ~uint64_t(0) : (uint64_t(1) << end) - 1) & (~uint64_t(0) << cursor);
+                if (firstNonSpace == string_view::npos && (block.nonSpace & range))
+                    firstNonSpace = offset + static_cast<size_t>(__builtin_ctzll(block.nonSpace & range));
+                if (firstSemicolon == string_view::npos && (block.semicolon & range))
+                    firstSemicolon = offset + static_cast<size_t>(__builtin_ctzll(block.semicolon & range));
+                if (end == 64)
+                    break;
+                lines.push_back(make_line(text, lineStart, offset + end, firstNonSpace, firstSemicolon));
+                lineStart = offset + end + 1;
+                firstNonSpace = firstSemicolon = string_view::npos;
+                newlines &= newlines - 1;
+                cursor = end + 1;
+                if (cursor == 64)
+                    break;
+            }
+        }
+        if (lineStart < n)
+            lines.push_back(make_line(text, lineStart, n, firstNonSpace, firstSemicolon));
+    }
+
+    BlockMasks masks_sse2(const char *p)
+    {
+        const __m128i newline = _mm_set1_epi8('\n');
+        const __m128i semicolon = _mm_set1_epi8(';');
+        const __m128i space = _mm_set1_epi8(' ');
+        const __m128i tab = _mm_set1_epi8('\t');
+        const __m128i controlRange = _mm_set1_epi8('\r' - '\t');
+        BlockMasks block = {0, 0, 0};
+        uint64_t spaces = 0;
+        for (int k = 0; k < 4; k++)
+        {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 16 * k));
+            // '\t'..'\r' viram 0..4; min_epu8 faz a comparação sem sinal.
+            __m128i control = _mm_sub_epi8(x, tab);
+            __m128i isControl = _mm_cmpeq_epi8(_mm_min_epu8(control, controlRange), control);
+            __m128i isSpace = _mm_or_si128(_mm_cmpeq_epi8(x, space), isControl);
+            int shift = 16 * k;
+            block.newline |= uint64_t(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(x, newline)))) << shift;
+            block.semicolon |= uint64_t(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(x, semicolon)))) << shift;
+            spaces |= uint64_t(static_cast<uint16_t>(_mm_movemask_epi8(isSpace))) << shift;
+        }
+        block.nonSpace = ~spaces;
+        return block;
+    }
+
+    __attribute__((target("avx2"))) BlockMasks masks_avx2(const char *p)
+    {
+        const __m256i newline = _mm256_set1_epi8('\n');
+        const __m256i semicolon = _mm256_set1_epi8(';');
+        const __m256i space = _mm256_set1_epi8(' ');
+        const __m256i tab = _mm256_set1_epi8('\t');
+        const __m256i controlRange = _mm256_set1_epi8('\r' - '\t');
+        BlockMasks block = {0, 0, 0};
+        uint64_t spaces = 0;
+        for (int k = 0; k < 2; k++)
+        {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 32 * k));
+            __m256i control = _mm256_sub_epi8(x, tab);
+            __m256i isControl = _mm256_cmpeq_epi8(_mm256_min_epu8(control, controlRange), control);
+            __m256i isSpace = _mm256_or_si256(_mm256_cmpeq_epi8(x, space), isControl);
+            int shift = 32 * k;
+            block.newline |= uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, newline)))) << shift;
+            block.semicolon |= uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, semicolon)))) << shift;
+            spaces |= uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(isSpace))) << shift;
+        }
+        block.nonSpace = ~spaces;
+        return block;
+    }
+
+    void scan_sse2(string_view text, vector<LineInfo> &lines)
+    {
+        scan_blocks(text, lines, masks_sse2);
+    }
+
+    __attribute__((target("avx2"))) void scan_avx2(string_view text, vector<LineInfo> &lines)
+    {
+        scan_blocks(text, lines, masks_avx2);
+    }
+
+    // a–z viram 0..25 depois de subtrair 'a'; só esses bytes perdem o bit 0x20.
+    void fold_sse2(char *text, size_t size)
+    {
+        const __m128i a = _mm_set1_epi8('a');
+        const __m128i letters = _mm_set1_epi8('z' - 'a');
+        const __m128i caseBit = _mm_set1_epi8('a' - 'A');
+        size_t i = 0;
+        for (; i + 16 <= size; i += 16)
+        {
+            __m128i *p = reinterpret_cast<__m128i *>(text + i);
+            __m128i x = _mm_loadu_si128(p);
+            __m128i offset = _mm_sub_epi8(x, a);
+            __m128i isLower = _mm_cmpeq_epi8(_mm_min_epu8(offset, letters), offset);
+            _mm_storeu_si128(p, _mm_sub_epi8(x, _mm_and_si128(isLower, caseBit)));
+        }
+        fold_tail(text, i, size);
+    }
+
+    __attribute__((target("avx2"))) void fold_avx2(char *text, size_t size)
+    {
+        const __m256i a = _mm256_set1_epi8('a');
+        const __m256i letters = _mm256_set1_epi8('z' - 'a');
+        const __m256i caseBit = _mm256_set1_epi8('a' - 'A');
+        size_t i = 0;
+        for (; i + 32 <= size; i += 32)
+        {
+            __m256i *p = reinterpret_cast<__m256i *>(text + i);
+            __m256i x = _mm256_loadu_si256(p);
+            __m256i offset = _mm256_sub_epi8(x, a);
+            __m256i isLower = _mm256_cmpeq_epi8(_mm256_min_epu8(offset, letters), offset);
+            _mm256_storeu_si256(p, _mm256_sub_epi8(x, _mm256_and_si256(isLower, caseBit)));
+        }
+        fold_tail(text, i, size);
+    }
+
+    bool has_avx2()
+    {
+        static const bool supported = __builtin_cpu_supports("avx2");
+        return supported;
+    }
+
+    // AVX2 quando o processador tem, a menos que set_text_scan_backend("sse2").
+    bool &use_avx2()
+    {
+        static bool selected = has_avx2();
+        return selected;
+    }
+#endif
+}
+
+void fold_upper_scalar(char *text, size_t size)
+{
+    fold_tail(text, 0, size);
+}
+
+void fold_upper(char *text, size_t size)
+{
+#if TEXTSCAN_X86
+    if (use_avx2())
+        fold_avx2(text, size);
+    else
+        fold_sse2(text, size);
+#else
+    fold_upper_scalar(text, size);
+#endif
+}
+
+void scan_lines_scalar(string_view text, vector<LineInfo> &lines)
+{
+    lines.clear();
+    size_t lineStart = 0;
+    size_t firstNonSpace = string_view::npos;
+    size_t firstSemicolon = string_view::npos;
+    for (size_t i = 0; i < text.size(); i++)
+    {
+        char c = text[i];
+        if (c == '\n')
+        {
+            lines.push_back(make_line(text, lineStart, i, firstNonSpace, firstSemicolon));
+            lineStart = i + 1;
+            firstNonSpace = firstSemicolon = string_view::npos;
+            continue;
+        }
+        if (firstNonSpace == string_view::npos && !is_space(static_cast<unsigned char>(c)))
+            firstNonSpace = i;
+        if (firstSemicolon == string_view::npos && c == ';')
+            firstSemicolon = i;
+    }
+    if (lineStart < text.size())
+        lines.push_back(make_line(text, lineStart, text.size(), firstNonSpace, firstSemicolon));
+}
+
+void scan_lines(string_view text, vector<LineInfo> &lines)
+{
+#if TEXTSCAN_X86
+    if (use_avx2())
+        scan_avx2(text, lines);
+    else
+        scan_sse2(text, lines);
+#else
+    scan_lines_scalar(text, lines);
+#endif
+}
+
+const char *text_scan_backend()
+{
+#if TEXTSCAN_X86
+    return use_avx2() ? "avx2" : "sse2";
+#else
+    return "escalar";
+#endif
+}
+
+bool set_text_scan_backend(string_view name)
+{
+#if TEXTSCAN_X86
+    if (name == "sse2" || (name == "avx2" && has_avx2()))
+    {
+        use_avx2() = name == "avx2";
+        return true;
+    }
+    return false;
+#else
+    return name == "escalar";
+#endif
+}
@@ -0,0 +1,53 @@
+#ifndef TEXT_SCAN_HPP
+#define TEXT_SCAN_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+// Varredura vetorizada do fonte, feita uma vez antes do pré-processamento:
+// converte o texto para maiúsculas no próprio buffer e classifica as linhas.
+// Com GCC/Clang em x86 usa AVX2 quando o processador tem (detectado em tempo
+// de execução) e SSE2 nos demais; fora de x86, ou com -DTEXTSCAN_SCALAR, usa
+// os laços escalares.
+
+// Converte a–z para A–Z em [text, text+size). Só ASCII, como toupper no
+// locale "C": bytes acima de 127 (UTF-8 nos comentários) não mudam.
+void fold_upper(char* text, size_t size);
+void fold_upper_scalar(char* text, size_t size);
+
+enum class LineKind : uint8_t {
+    BLANK,   // só espaços
+    COMMENT, // o 1º caractere não-espaço é ';'
+    CODE,
+};
+
+// Linha do fonte, sem o '\n'. `codeLength` é a posição do primeiro ';' na
+// linha (o código acaba ali) ou `length` se não há comentário.
+struct LineInfo {
+    size_t begin;
+    uint32_t length;
+    uint32_t codeLength;
+    LineKind kind;
+};
+
+// Divide `text` em linhas com a mesma semântica do SourceBuffer (um '\n' final
+// não cria linha vazia) e classifica cada uma. Cada bloco de 64 bytes vira
+// três máscaras de bits ('\n', ';' e não-espaço); as linhas saem dos bits de
+// '\n' e o primeiro não-espaço e o primeiro ';' de cada linha são achados com
+// ctz, sem olhar byte a byte. `lines` é reaproveitado (clear, mantendo a
+// capacidade).
+void scan_lines(string_view text, vector<LineInfo>& lines);
+void scan_lines_scalar(string_view text, vector<LineInfo>& lines);
+
+// Implementação usada por fold_upper/scan_lines: "avx2", "sse2" ou "escalar".
+const char* text_scan_backend();
+// Troca a implementação de fold_upper/scan_lines (ex: "sse2" num processador
+// com AVX2, para comparar os caminhos em bench --verify). Falso, sem trocar,
+// se ela não existir neste processador ou build. Não é thread-safe.
+bool set_text_scan_backend(string_view name);
+
+#endif // TEXT_SCAN_HPP
@@ -2,10 +2,13 @@
 #define TOKEN_HPP
 
 #include <string>
+#include <string_view>
 #include <vector>
 
 using namespace std;
 
+struct OpInfo;
+
 enum class TokenType {
     INSTRUCTION,
     LABEL,
@@ -16,12 +19,18 @@ enum class TokenType {
     UNKNOWN
 };
 
+// Os campos string_view apontam para a linha passada ao tokenizador e só são
+// válidos enquanto ela existir.
 struct Token {
     TokenType type;
-    string value;
+    string_view value;
     int lineNumber;
+    // Operando já separado: em "LABEL+3" (ou "LABEL + 3") base = "LABEL" e
+    // offset = "3". Sem '+', base == value e offset fica vazio.
+    string_view base;
+    string_view offset;
+    // Entrada da OPTAB para INSTRUCTION/DIRECTIVE (evita uma segunda busca no montador).
+    const OpInfo* op = nullptr;
 };
 
-vector<Token> tokenize(const string& line);
-
-#endif
\ No newline at end of file
+#endif
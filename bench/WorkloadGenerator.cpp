@@ -0,0 +1,213 @@
+#include "WorkloadGenerator.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+const char *const WORKLOAD_OPTIONS_USAGE =
+    "  --seed N            seed do gerador (padrao 1)\n"
+    "  --instructions N    linhas no corpo do programa (padrao 100000)\n"
+    "  --labels F          fracao das linhas com rotulo (padrao 0.2)\n"
+    "  --forward F         fracao das referencias adiante (padrao 0.5)\n"
+    "  --offsets F         fracao dos operandos LABEL+offset (padrao 0.1)\n"
+    "  --macros N          numero de macros definidas (padrao 4)\n"
+    "  --depth N           aninhamento das macros (padrao 2)\n"
+    "  --calls F           fracao das linhas que chamam macro (padrao 0.05)\n"
+    "  --errors F          fracao das linhas com erro (padrao 0)\n";
+
+namespace
+{
+    // splitmix64: sequência idêntica em qualquer compilador/biblioteca, ao
+    // contrário das distribuições de <random>.
+    class Random
+    {
+    public:
+        explicit Random(uint64_t seed) : state(seed) {}
+
+        uint64_t next()
+        {
+            uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+
+        // Inteiro em [0, bound).
+        size_t below(size_t bound) { return bound == 0 ? 0 : static_cast<size_t>(next() % bound); }
+        // Verdadeiro com probabilidade `p`.
+        bool chance(double p) { return static_cast<double>(next() >> 11) * 0x1.0p-53 < p; }
+
+    private:
+        uint64_t state;
+    };
+
+    const char *const ONE_OPERAND[] = {"ADD", "SUB", "MULT", "DIV", "JMP", "JMPN", "JMPP", "JMPZ",
+                                       "LOAD", "STORE", "INPUT", "OUTPUT"};
+
+    const char *const ERRORS[] = {
+        "FOO X",         // instrução desconhecida
+        "ADD",           // parâmetros a menos
+        "COPY D0",       // parâmetros a menos
+        "LOAD D0, D1",   // parâmetros a mais
+        "CONST X",       // valor inválido
+        "SPACE 0",       // valor inválido
+        "1BAD: STOP",    // rótulo inválido
+        "LOAD 2+X",      // operando inválido
+        "LOAD NAODEF",   // rótulo não definido
+    };
+
+    class Generator
+    {
+    public:
+        Generator(const WorkloadConfig &config, ostream &out) : config(config), out(out), random(config.seed) {}
+
+        void run()
+        {
+            size_t dataLabels = max<size_t>(4, config.instructions / 8);
+            size_t depth = max<size_t>(1, config.macroDepth);
+            write_macros(depth);
+
+            // Os rótulos de código são numerados na ordem de definição; as
+            // referências adiante usam os próximos rótulos ou os dados do fim.
+            size_t plannedLabels = static_cast<size_t>(static_cast<double>(config.instructions) * config.labelDensity) + 1;
+            for (size_t i = 0; i < config.instructions; i++)
+            {
+                if (random.chance(config.errorRate))
+                {
+                    out << ERRORS[random.below(sizeof(ERRORS) / sizeof(ERRORS[0]))] << "\n";
+                    continue;
+                }
+                if (config.macroCount > 0 && random.chance(config.macroCallRatio))
+                {
+                    out << "M" << random.below(config.macroCount) << " " << operand(dataLabels, plannedLabels) << ", "
+                        << operand(dataLabels, plannedLabels) << "\n";
+                    continue;
+                }
+                if (random.chance(config.labelDensity))
+                {
+                    out << "L" << definedLabels++ << ": ";
+                }
+                size_t kind = random.below(20);
+                if (kind == 0)
+                    out << "COPY " << operand(dataLabels, plannedLabels) << ", " << operand(dataLabels, plannedLabels);
+                else if (kind == 1)
+                    out << "STOP";
+                else
+                    out << ONE_OPERAND[random.below(sizeof(ONE_OPERAND) / sizeof(ONE_OPERAND[0]))] << " "
+                        << operand(dataLabels, plannedLabels);
+                out << "\n";
+            }
+            out << "STOP\n";
+
+            // Rótulos de código planejados mas não usados como definição.
+            while (definedLabels < plannedLabels + 1)
+            {
+                out << "L" << definedLabels++ << ": SPACE\n";
+            }
+            for (size_t i = 0; i < dataLabels; i++)
+            {
+                if (i % 3 == 0)
+                    out << "D" << i << ": CONST " << random.below(100) << "\n";
+                else
+                    out << "D" << i << ": SPACE\n";
+            }
+        }
+
+    private:
+        // Mi recebe &A e &B; quando não está no início de uma cadeia de
+        // `depth` macros, chama M(i-1) com os argumentos trocados.
+        void write_macros(size_t depth)
+        {
+            for (size_t i = 0; i < config.macroCount; i++)
+            {
+                out << "M" << i << ": MACRO &A, &B\n";
+                out << "LOAD &A\n";
+                out << "ADD &B\n";
+                if (i % depth != 0)
+                    out << "M" << i - 1 << " &B, &A\n";
+                out << "STORE &A\n";
+                out << "ENDMACRO\n";
+            }
+        }
+
+        string operand(size_t dataLabels, size_t plannedLabels)
+        {
+            string name;
+            bool forward = random.chance(config.forwardRefRatio) || definedLabels == 0;
+            if (!forward)
+                name = "L" + to_string(random.below(definedLabels));
+            else if (definedLabels < plannedLabels && random.chance(0.5))
+                name = "L" + to_string(definedLabels + random.below(plannedLabels - definedLabels + 1));
+            else
+                name = "D" + to_string(random.below(dataLabels));
+            if (random.chance(config.offsetRatio))
+                name += "+" + to_string(random.below(4));
+            return name;
+        }
+
+        const WorkloadConfig &config;
+        ostream &out;
+        Random random;
+        size_t definedLabels = 0;
+    };
+
+    size_t parse_size(const string &value)
+    {
+        size_t used = 0;
+        unsigned long long parsed = stoull(value, &used);
+        if (used != value.size())
+            throw invalid_argument(value);
+        return static_cast<size_t>(parsed);
+    }
+
+    double parse_ratio(const string &value)
+    {
+        size_t used = 0;
+        double parsed = stod(value, &used);
+        if (used != value.size() || parsed < 0 || parsed > 1)
+            throw invalid_argument(value);
+        return parsed;
+    }
+}
+
+void generate_workload(const WorkloadConfig &config, ostream &out)
+{
+    Generator(config, out).run();
+}
+
+bool parse_workload_option(int &i, int argc, char *argv[], WorkloadConfig &config)
+{
+    string arg = argv[i];
+    static const vector<string> names = {"--seed", "--instructions", "--labels", "--forward", "--offsets",
+                                         "--macros", "--depth", "--calls", "--errors"};
+    bool known = false;
+    for (const string &name : names)
+        known = known || arg == name;
+    if (!known)
+        return false;
+    if (i + 1 >= argc)
+        throw invalid_argument("Falta o valor de " + arg);
+    string value = argv[++i];
+
+    if (arg == "--seed")
+        config.seed = parse_size(value);
+    else if (arg == "--instructions")
+        config.instructions = parse_size(value);
+    else if (arg == "--labels")
+        config.labelDensity = parse_ratio(value);
+    else if (arg == "--forward")
+        config.forwardRefRatio = parse_ratio(value);
+    else if (arg == "--offsets")
+        config.offsetRatio = parse_ratio(value);
+    else if (arg == "--macros")
+        config.macroCount = parse_size(value);
+    else if (arg == "--depth")
+        config.macroDepth = parse_size(value);
+    else if (arg == "--calls")
+        config.macroCallRatio = parse_ratio(value);
+    else
+        config.errorRate = parse_ratio(value);
+    return true;
+}
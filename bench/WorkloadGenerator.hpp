@@ -0,0 +1,35 @@
+#ifndef WORKLOAD_GENERATOR_HPP
+#define WORKLOAD_GENERATOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+using namespace std;
+
+// Parâmetros do programa sintético. A mesma configuração (inclusive a seed)
+// gera sempre o mesmo texto, em qualquer plataforma.
+struct WorkloadConfig {
+    uint64_t seed = 1;
+    size_t instructions = 100000;   // linhas no corpo do programa
+    double labelDensity = 0.2;      // fração das linhas com rótulo
+    double forwardRefRatio = 0.5;   // fração das referências a rótulos ainda não definidos
+    double offsetRatio = 0.1;       // fração dos operandos no formato LABEL+offset
+    size_t macroCount = 4;
+    size_t macroDepth = 2;          // macros aninhadas por chamada (1 = sem aninhamento)
+    double macroCallRatio = 0.05;   // fração das linhas que chamam uma macro
+    double errorRate = 0.0;         // fração das linhas com erro léxico/semântico
+};
+
+// Escreve o programa .asm em `out`.
+void generate_workload(const WorkloadConfig& config, ostream& out);
+
+// Interpreta uma opção do gerador (ex: "--instructions 1000") a partir de
+// argv[i], avançando `i` sobre o valor. Retorna false se não for uma opção do
+// gerador; lança invalid_argument se o valor for inválido.
+bool parse_workload_option(int& i, int argc, char* argv[], WorkloadConfig& config);
+
+// Descrição das opções para as mensagens de uso.
+extern const char* const WORKLOAD_OPTIONS_USAGE;
+
+#endif // WORKLOAD_GENERATOR_HPP
@@ -0,0 +1,463 @@
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "WorkloadGenerator.hpp"
+#include "Assembler.hpp"
+#include "Driver.hpp"
+#include "LexicalAnalyzer.hpp"
+#include "LineStream.hpp"
+#include "Loader.hpp"
+#include "Log.hpp"
+#include "Memory.hpp"
+#include "MemoryAssembler.hpp"
+#include "ObjectFile.hpp"
+#include "Preprocessor.hpp"
+#include "SourceBuffer.hpp"
+#include "TextScan.hpp"
+
+using namespace std;
+
+namespace
+{
+    namespace fs = std::filesystem;
+
+    // Entrega as linhas de um bloco, que pode ser relido a cada iteração.
+    class BatchLineSource : public LineSource
+    {
+    public:
+        explicit BatchLineSource(const LineBatch &lines) : lines(lines) {}
+        bool next(string_view &line) override
+        {
+            if (position >= lines.size())
+                return false;
+            line = lines.line(position++);
+            return true;
+        }
+
+    private:
+        const LineBatch &lines;
+        size_t position = 0;
+    };
+
+    struct BenchResult
+    {
+        string name;
+        size_t iterations = 0;
+        double seconds = 0;
+        size_t items = 0;  // itens por iteração (linhas ou words)
+        size_t bytes = 0;  // bytes de entrada por iteração
+        size_t allocatedBytes = 0;
+        size_t allocations = 0;
+    };
+
+    struct BenchOptions
+    {
+        double minTime = 0.5;
+        string only;
+        bool verify = false;
+    };
+
+    // Repete `body` até somar pelo menos `minTime` segundos, depois de uma
+    // execução de aquecimento. Alocações são a média por iteração.
+    template <typename Body>
+    void run_bench(const BenchOptions &options, const string &name, size_t items, size_t bytes, Body body)
+    {
+        if (!options.only.empty() && name.find(options.only) == string::npos)
+            return;
+        body();
+
+        BenchResult result;
+        result.name = name;
+        result.items = items;
+        result.bytes = bytes;
+        // Contagem de alocações: todo operator new do processo passa pelo
+        // de Memory.cpp (compilado com -DMEMORY_COUNT_ALLOCATIONS).
+        AllocationCount before = process_allocations();
+        auto start = chrono::steady_clock::now();
+        do
+        {
+            body();
+            result.iterations++;
+            result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        } while (result.seconds < options.minTime);
+        AllocationCount allocated = process_allocations() - before;
+        result.allocatedBytes = allocated.bytes / result.iterations;
+        result.allocations = allocated.count / result.iterations;
+
+        double perIteration = result.seconds / static_cast<double>(result.iterations);
+        cout << left << setw(22) << result.name << right << setw(8) << result.iterations
+             << fixed << setprecision(3) << setw(12) << perIteration * 1e3
+             << setprecision(0) << setw(14) << static_cast<double>(result.items) / perIteration
+             << setprecision(1) << setw(10) << static_cast<double>(result.bytes) / perIteration / 1e6
+             << setw(14) << result.allocatedBytes << setw(12) << result.allocations << "\n";
+    }
+
+    void print_usage(const char *program)
+    {
+        cerr << "Uso: " << program << " [opcoes]\n"
+             << "  --input ARQ         usa um .asm existente em vez de gerar um\n"
+             << "  --min-time S        tempo minimo por benchmark em segundos (padrao 0.5)\n"
+             << "  --only NOME         roda so os benchmarks cujo nome contem NOME\n"
+             << "  --verify            compara as implementacoes em vez de medir\n"
+             << WORKLOAD_OPTIONS_USAGE;
+    }
+
+    // --verify: cada caminho otimizado contra a sua referência, no programa do
+    // benchmark e em casos aleatórios. Imprime uma linha por comparação e
+    // retorna falso na primeira diferença.
+    constexpr size_t VERIFY_CASES = 20000;
+
+    bool report(const string &name, size_t cases, const string &mismatch)
+    {
+        if (mismatch.empty())
+            cout << left << setw(28) << name << right << setw(8) << cases << " casos OK\n";
+        else
+            cout << left << setw(28) << name << " DIFERENTE: " << mismatch << "\n";
+        return mismatch.empty();
+    }
+
+    bool same_lines(const vector<LineInfo> &a, const vector<LineInfo> &b)
+    {
+        if (a.size() != b.size())
+            return false;
+        for (size_t i = 0; i < a.size(); i++)
+        {
+            if (a[i].begin != b[i].begin || a[i].length != b[i].length || a[i].codeLength != b[i].codeLength ||
+                a[i].kind != b[i].kind)
+                return false;
+        }
+        return true;
+    }
+
+    // Texto aleatório com o que as máscaras distinguem: letras nas duas
+    // caixas e os vizinhos de 'a'/'z' na tabela, brancos, '\n', ';' e bytes
+    // acima de 127.
+    string random_text(mt19937 &rng, size_t size)
+    {
+        static const string alphabet = "abcxyzABCXYZ@[`{09 \t\r\v\f\n\n\n;;,:+\x7f\x80\xc3\xa9\xff";
+        uniform_int_distribution<size_t> pick(0, alphabet.size() - 1);
+        string text(size, ' ');
+        for (char &c : text)
+            c = alphabet[pick(rng)];
+        return text;
+    }
+
+    // fold_upper e scan_lines em cada implementação vetorizada contra as
+    // escalares. Os casos aleatórios cobrem tamanhos em volta dos blocos de
+    // 16/32/64 bytes e inícios desalinhados.
+    bool verify_text_scan(const string &sourceText, mt19937 &rng)
+    {
+        const string original = text_scan_backend();
+        bool ok = true;
+        for (const char *backend : {"avx2", "sse2"})
+        {
+            if (!set_text_scan_backend(backend))
+            {
+                cout << left << setw(28) << string("text_scan.") + backend << " indisponivel\n";
+                continue;
+            }
+            string foldMismatch, scanMismatch;
+            vector<LineInfo> lines, expected;
+            uniform_int_distribution<size_t> size(0, 300);
+            uniform_int_distribution<size_t> offset(0, 31);
+            for (size_t i = 0; i <= VERIFY_CASES && foldMismatch.empty() && scanMismatch.empty(); i++)
+            {
+                // Caso 0: o fonte do benchmark inteiro.
+                string text = i == 0 ? sourceText : random_text(rng, offset(rng) + size(rng));
+                size_t start = i == 0 ? 0 : min(text.size(), offset(rng));
+                string folded = text, reference = text;
+                fold_upper(folded.data() + start, folded.size() - start);
+                fold_upper_scalar(reference.data() + start, reference.size() - start);
+                if (folded != reference)
+                    foldMismatch = "caso " + to_string(i) + " (" + to_string(text.size()) + " bytes)";
+                string_view view = string_view(text).substr(start);
+                scan_lines(view, lines);
+                scan_lines_scalar(view, expected);
+                if (!same_lines(lines, expected))
+                    scanMismatch = "caso " + to_string(i) + " (" + to_string(view.size()) + " bytes)";
+            }
+            ok = report(string("fold_upper.") + backend, VERIFY_CASES + 1, foldMismatch) && ok;
+            ok = report(string("scan_lines.") + backend, VERIFY_CASES + 1, scanMismatch) && ok;
+        }
+        set_text_scan_backend(original);
+        return ok;
+    }
+
+    // relocate_words em cada implementação vetorizada contra
+    // relocate_words_scalar, com mapas vazios, cheios e aleatórios e words e
+    // bases nos extremos de int (a soma dá a volta em 32 bits).
+    bool verify_relocation(const ObjectImage &image, mt19937 &rng)
+    {
+        const string original = relocation_backend();
+        bool ok = true;
+        for (const char *backend : {"avx2", "sse2"})
+        {
+            if (!set_relocation_backend(backend))
+            {
+                cout << left << setw(28) << string("relocate.") + backend << " indisponivel\n";
+                continue;
+            }
+            string mismatch;
+            uniform_int_distribution<size_t> size(0, 300);
+            uniform_int_distribution<int> word(numeric_limits<int>::min(), numeric_limits<int>::max());
+            uniform_int_distribution<int> density(0, 3);
+            for (size_t i = 0; i <= VERIFY_CASES && mismatch.empty(); i++)
+            {
+                // Caso 0: a imagem do benchmark.
+                vector<int> words = image.words;
+                vector<uint8_t> map = image.relocationMap;
+                int base = 1000;
+                if (i > 0)
+                {
+                    words.resize(size(rng));
+                    for (int &w : words)
+                        w = word(rng);
+                    map.assign((words.size() + 7) / 8, 0);
+                    int fill = density(rng); // 0: vazio, 1: esparso, 2: aleatório, 3: cheio
+                    for (uint8_t &bits : map)
+                        bits = fill == 0 ? 0 : fill == 3 ? 0xff : fill == 1 ? uint8_t(1u << (rng() % 8)) : uint8_t(rng());
+                    base = word(rng);
+                }
+                map.resize((words.size() + 7) / 8, 0);
+                vector<int> reference = words;
+                relocate_words(words.data(), words.size(), map.data(), base);
+                relocate_words_scalar(reference.data(), reference.size(), map.data(), base);
+                if (words != reference)
+                    mismatch = "caso " + to_string(i) + " (" + to_string(words.size()) + " words)";
+            }
+            ok = report(string("relocate.") + backend, VERIFY_CASES + 1, mismatch) && ok;
+        }
+        set_relocation_backend(original);
+        return ok;
+    }
+
+    // Saída da compilação de `source`: .o1, .o2, .obj e as mensagens de erro.
+    string compile_outputs(const string &source, const CompileOptions &options)
+    {
+        ostringstream log;
+        compile_file(source, options, log);
+        string outputs = log.str();
+        for (const char *extension : {".o1", ".o2", ".obj"})
+            outputs += '\0' + read_file_contents(change_extension(source, extension));
+        return outputs;
+    }
+
+    // --split com vários -j contra a montagem em uma passagem: mesmos bytes
+    // nos objetos e as mesmas mensagens de erro.
+    bool verify_split(const string &source)
+    {
+        CompileOptions options;
+        options.writePre = false;
+        options.writeBinary = true;
+        options.logLevel = LogLevel::ERROR;
+        const string reference = compile_outputs(source, options);
+        bool ok = true;
+        for (unsigned jobs : {2u, 3u, 4u, 8u, 16u})
+        {
+            options.splitJobs = jobs;
+            bool same = compile_outputs(source, options) == reference;
+            ok = report("split.j" + to_string(jobs), 1, same ? "" : "objetos ou erros diferentes da passagem unica") && ok;
+        }
+        return ok;
+    }
+}
+
+// Benchmarks de cada estágio do pipeline sobre um programa sintético
+// determinístico (ou um .asm informado com --input).
+int main(int argc, char *argv[])
+{
+    WorkloadConfig config;
+    BenchOptions options;
+    string input;
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        try
+        {
+            if (parse_workload_option(i, argc, argv, config))
+                continue;
+            if (arg == "--verify")
+            {
+                options.verify = true;
+                continue;
+            }
+            if ((arg == "--input" || arg == "--min-time" || arg == "--only") && i + 1 < argc)
+            {
+                string value = argv[++i];
+                if (arg == "--input")
+                    input = value;
+                else if (arg == "--min-time")
+                    options.minTime = stod(value);
+                else
+                    options.only = value;
+                continue;
+            }
+        }
+        catch (const exception &)
+        {
+            cerr << "Valor invalido para " << arg << endl;
+            return 1;
+        }
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    // Os arquivos do benchmark ficam num diretório temporário próprio.
+    fs::path dir = fs::temp_directory_path() / ("asm_bench_" + to_string(getpid()));
+    fs::create_directories(dir);
+    string source = (dir / "workload.asm").string();
+    if (input.empty())
+    {
+        ofstream file(source);
+        generate_workload(config, file);
+    }
+    else
+    {
+        fs::copy_file(input, source, fs::copy_options::overwrite_existing);
+    }
+
+    ostringstream discarded;
+    Logger quiet(discarded, LogLevel::OFF);
+
+    // Entrada de cada estágio: linhas do fonte, linhas expandidas (como o
+    // montador as recebe) e a imagem do objeto.
+    size_t sourceLines = 0;
+    size_t sourceBytes = fs::file_size(source);
+    string sourceText;
+    {
+        SourceBuffer buffer(source);
+        sourceLines = buffer.lineCount();
+        sourceText.assign(buffer.text());
+    }
+    MemoryLines expanded;
+    Preprocessor(quiet).process(source, expanded);
+    const LineBatch &lines = expanded.lines();
+    // As linhas expandidas já saem em maiúsculas do pré-processador.
+    size_t expandedBytes = lines.text.size() + lines.size();
+    Assembler reference(quiet);
+    reference.set_folded_input(true);
+    BatchLineSource referenceInput(lines);
+    reference.pass(referenceInput);
+    ObjectImage image = reference.object_image();
+    string binaryPath = (dir / "workload.obj").string();
+
+    cout << "Entrada: " << sourceLines << " linhas (" << sourceBytes << " bytes), " << lines.size()
+         << " linhas expandidas, " << image.words.size() << " words, " << reference.getErrors().size() << " erros\n\n";
+    if (options.verify)
+    {
+        mt19937 rng(static_cast<uint32_t>(config.seed));
+        bool ok = verify_text_scan(sourceText, rng);
+        ok = verify_relocation(image, rng) && ok;
+        ok = verify_split(source) && ok;
+        fs::remove_all(dir);
+        return ok ? 0 : 1;
+    }
+    if (!allocation_counting)
+        cout << "(alocacoes nao contadas: compile com -DMEMORY_COUNT_ALLOCATIONS)\n";
+    cout << left << setw(22) << "benchmark" << right << setw(8) << "iter" << setw(12) << "ms/iter"
+         << setw(14) << "itens/s" << setw(10) << "MB/s" << setw(14) << "bytes aloc." << setw(12) << "alocacoes" << "\n";
+
+    // Micro: varredura do fonte (maiúsculas e classificação das linhas), na
+    // implementação vetorizada e na escalar (itens = linhas do fonte). A cópia
+    // do fonte entra na medida para cada iteração converter o texto original.
+    string folded;
+    vector<LineInfo> lineInfo;
+    run_bench(options, string("fold_upper.") + text_scan_backend(), sourceLines, sourceBytes, [&]
+              {
+        folded.assign(sourceText);
+        fold_upper(folded.data(), folded.size()); });
+    run_bench(options, "fold_upper.escalar", sourceLines, sourceBytes, [&]
+              {
+        folded.assign(sourceText);
+        fold_upper_scalar(folded.data(), folded.size()); });
+    run_bench(options, string("scan_lines.") + text_scan_backend(), sourceLines, sourceBytes, [&]
+              { scan_lines(sourceText, lineInfo); });
+    run_bench(options, "scan_lines.escalar", sourceLines, sourceBytes, [&]
+              { scan_lines_scalar(sourceText, lineInfo); });
+
+    // Micro: só o scanner, linha a linha (itens = linhas expandidas).
+    run_bench(options, "tokenize", lines.size(), expandedBytes, [&]
+              {
+        LexicalAnalyzer lexer;
+        vector<Token> tokens;
+        int lineNumber = 0;
+        for (size_t i = 0; i < lines.size(); i++) {
+            try {
+                lexer.tokenize(lines.line(i), ++lineNumber, tokens);
+            } catch (const LexicalException &) {
+            }
+        } });
+
+    // Pré-processador completo, com a saída descartada (itens = linhas do fonte).
+    run_bench(options, "preprocess", sourceLines, sourceBytes, [&]
+              {
+        NullLineSink sink;
+        Preprocessor(quiet).process(source, sink); });
+
+    // Passagem 1 do montador sobre as linhas já expandidas.
+    run_bench(options, "assembler.pass", lines.size(), expandedBytes, [&]
+              {
+        Assembler assembler(quiet);
+        assembler.set_folded_input(true);
+        BatchLineSource in(lines);
+        assembler.pass(in); });
+
+    // Escritores de objeto (itens = words).
+    run_bench(options, "write_text_object", image.words.size(), 0, [&]
+              {
+        ostringstream out;
+        write_text_object(out, image.words); });
+    run_bench(options, "write_binary_object", image.words.size(), 0, [&]
+              { write_binary_object(binaryPath, image); });
+
+    // Relocação da imagem para outro endereço (itens = words), vetorizada e
+    // escalar, e a carga de 16 cópias numa única memória.
+    vector<int> relocated = image.words;
+    vector<uint8_t> relocationMap = image.relocationMap;
+    relocationMap.resize((image.words.size() + 7) / 8, 0);
+    run_bench(options, string("relocate.") + relocation_backend(), image.words.size(), 0, [&]
+              { relocate_words(relocated.data(), relocated.size(), relocationMap.data(), 1000); });
+    run_bench(options, "relocate.escalar", image.words.size(), 0, [&]
+              { relocate_words_scalar(relocated.data(), relocated.size(), relocationMap.data(), 1000); });
+    vector<ObjectImage> copies(16, image);
+    for (ObjectImage &copyImage : copies)
+        copyImage.pending.clear();
+    vector<int> memory;
+    run_bench(options, "load_images.x16", image.words.size() * copies.size(), 0, [&]
+              { load_images(copies, memory); });
+
+    // API em memória com a mesma instância: o programa inteiro e muitos
+    // trechos pequenos (itens = trechos). Depois do aquecimento os trechos
+    // não devem alocar.
+    MemoryAssembler memoryAssembler;
+    run_bench(options, "memory_assembler", sourceLines, sourceBytes, [&]
+              { memoryAssembler.assemble(sourceText); });
+    const string snippet = "LOOP: LOAD N\nSUB ONE\nSTORE N\nJMPP LOOP\nOUTPUT N\nSTOP\nN: CONST 5\nONE: CONST 1\n";
+    const size_t snippetCount = 1000;
+    run_bench(options, "memory_assembler.snip", snippetCount, snippet.size() * snippetCount, [&]
+              {
+        for (size_t i = 0; i < snippetCount; i++)
+            memoryAssembler.assemble(snippet); });
+
+    // Macro: o arquivo inteiro como o `compiler` faz (sem .pre).
+    CompileOptions compileOptions;
+    compileOptions.writePre = false;
+    compileOptions.logLevel = LogLevel::OFF;
+    run_bench(options, "compile_file", sourceLines, sourceBytes, [&]
+              { compile_file(source, compileOptions, discarded); });
+    compileOptions.threaded = false;
+    run_bench(options, "compile_file.seq", sourceLines, sourceBytes, [&]
+              { compile_file(source, compileOptions, discarded); });
+
+    fs::remove_all(dir);
+    return 0;
+}
@@ -0,0 +1,49 @@
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include "WorkloadGenerator.hpp"
+
+using namespace std;
+
+// Gera um programa sintético para os benchmarks (ou para testar o montador
+// com entradas grandes): gen_workload [opções] [saida.asm]
+int main(int argc, char *argv[])
+{
+    WorkloadConfig config;
+    string output;
+    for (int i = 1; i < argc; i++)
+    {
+        string option = argv[i];
+        try
+        {
+            if (parse_workload_option(i, argc, argv, config))
+                continue;
+        }
+        catch (const exception &)
+        {
+            cerr << "Valor invalido para " << option << endl;
+            return 1;
+        }
+        if (argv[i][0] == '-' || !output.empty())
+        {
+            cerr << "Uso: " << argv[0] << " [opcoes] [saida.asm]\n" << WORKLOAD_OPTIONS_USAGE;
+            return 1;
+        }
+        output = argv[i];
+    }
+
+    if (output.empty())
+    {
+        generate_workload(config, cout);
+        return 0;
+    }
+    ofstream file(output);
+    if (!file.is_open())
+    {
+        cerr << "Nao foi possivel abrir o arquivo de saida: " << output << endl;
+        return 1;
+    }
+    generate_workload(config, file);
+    return 0;
+}
@@ -1,50 +1,64 @@
-#include "Preprocessor.hpp"
-// #include "Assembler.hpp"
+#include <csignal>
 #include <iostream>
 #include <string>
-#include "Assembler.hpp"
+#include <thread>
+#include <vector>
+#include "CommandLine.hpp"
+#include "Protocol.hpp"
+#include "Server.hpp"
 
 using namespace std;
 
-string change_extension(const string& filename, const string& new_ext) {
-    size_t last_dot = filename.find_last_of(".");
-    if (last_dot == string::npos) {
-        return filename + new_ext;
+AssemblerServer* activeServer = nullptr;
+
+void stop_server(int) {
+    if (activeServer) {
+        activeServer->stop();
     }
-    return filename.substr(0, last_dot) + new_ext;
 }
 
-int main(int argc, char* argv[]) {
-    string input_filename;
-
-    // Valida os argumentos da linha de comando.
-    if (argc == 2) {
-        input_filename = argv[1];
-    } else {
-        cout << "Nenhum arquivo informado. Usando example.asm para debug." << endl;
-        input_filename = "example.asm";
+// `compiler --serve [SOCKET] [-j N]`: atende os pedidos do cliente
+// (tools/asmc.cpp) até SIGINT/SIGTERM ou um pedido "shutdown".
+int serve(const string& program, const vector<string>& args) {
+    string socketPath;
+    unsigned workers = thread::hardware_concurrency();
+    for (size_t i = 1; i < args.size(); i++) {
+        const string& arg = args[i];
+        if (arg.rfind("-j", 0) == 0) {
+            string value = arg.size() > 2 ? arg.substr(2) : (i + 1 < args.size() ? args[++i] : string());
+            try {
+                workers = static_cast<unsigned>(stoul(value));
+            } catch (const exception&) {
+                cerr << "Uso: " << program << " --serve [SOCKET] [-j N]" << endl;
+                return 1;
+            }
+        } else {
+            socketPath = arg;
+        }
     }
-    string pre_filename = change_extension(input_filename, ".pre");
-    string o1_filename = change_extension(input_filename, ".o1");
-    string o2_filename = change_extension(input_filename, ".o2");
 
     try {
-        // Pré-processamento
-        cout << "Iniciando Pre-processamento..." << endl;
-        Preprocessor preprocessor;
-        preprocessor.process(input_filename, pre_filename);
-        cout << "Pre-processamento concluido. Saida em: " << pre_filename << endl;
-
-        // Executa a Passagem 1: Montagem.
-        cout << "Iniciando Passagem 1: Montagem..." << endl;
-        Assembler assembler;
-        assembler.assemble(pre_filename, o1_filename, o2_filename);
-        // cout << "Montagem concluida. Saidas em: " << o1_filename << " e " << o2_filename << endl;
-
+        if (socketPath.empty()) {
+            socketPath = default_socket_path();
+        }
+        AssemblerServer server(socketPath, workers);
+        activeServer = &server;
+        signal(SIGINT, stop_server);
+        signal(SIGTERM, stop_server);
+        cout << "Servidor escutando em " << socketPath << " (" << workers << " worker(s))." << endl;
+        server.run();
+        activeServer = nullptr;
     } catch (const exception& e) {
-        cerr << "Erro fatal durante a compilacao: " << e.what() << endl;
+        cerr << e.what() << endl;
         return 1;
     }
-
     return 0;
-}
\ No newline at end of file
+}
+
+int main(int argc, char* argv[]) {
+    vector<string> args(argv + 1, argv + argc);
+    if (!args.empty() && args[0] == "--serve") {
+        return serve(argv[0], args);
+    }
+    return run_command_line(argv[0], args, cout, cerr);
+}
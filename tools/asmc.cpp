@@ -0,0 +1,135 @@
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "Protocol.hpp"
+
+using namespace std;
+
+void print_usage(const char* program) {
+    cerr << "Uso: " << program << " [--socket CAMINHO] [--shutdown] [--stdin [-O]] [argumentos do compiler...]" << endl;
+}
+
+// Sem servidor, executa o próprio `compiler` ($ASM_COMPILER ou o do PATH) com
+// os mesmos argumentos: para quem chama, o resultado é o mesmo.
+int run_locally(const vector<string>& args) {
+    const char* env = getenv("ASM_COMPILER");
+    string compiler = env && *env ? env : "compiler";
+    vector<char*> argv;
+    argv.push_back(compiler.data());
+    for (const string& arg : args) {
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+    execvp(compiler.c_str(), argv.data());
+    cerr << "Servidor indisponivel e nao foi possivel executar " << compiler << endl;
+    return 1;
+}
+
+// Cliente do `compiler --serve`. Repassa a linha de comando ao servidor, que
+// a executa no diretório atual daqui, e reproduz a saída e o código de
+// retorno do `compiler`. Com --stdin, envia o texto do fonte e imprime o .o2
+// (stdout) e os erros (stderr), sem gravar arquivos.
+int main(int argc, char* argv[]) {
+    string socketPath;
+    bool fromStdin = false;
+    bool optimize = false;
+    bool shutdown = false;
+    vector<string> args;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--socket") {
+            if (i + 1 >= argc) {
+                print_usage(argv[0]);
+                return 1;
+            }
+            socketPath = argv[++i];
+        } else if (arg == "--stdin") {
+            fromStdin = true;
+        } else if (arg == "--shutdown") {
+            shutdown = true;
+        } else {
+            if (arg == "-O" || arg == "--optimize") {
+                optimize = true;
+            }
+            args.push_back(arg);
+        }
+    }
+
+    if (socketPath.empty()) {
+        try {
+            socketPath = default_socket_path();
+        } catch (const exception& e) {
+            cerr << e.what() << endl;
+            return 1;
+        }
+    }
+
+    // O servidor roda em outro diretório: os pedidos rodam lá no diretório
+    // atual daqui.
+    char cwd[4096];
+    string currentDir = getcwd(cwd, sizeof(cwd)) ? cwd : "";
+    Message request;
+    if (shutdown) {
+        request.add("type", "shutdown");
+    } else if (fromStdin) {
+        request.add("type", "assemble");
+        request.add("cwd", currentDir);
+        request.add("source", string(istreambuf_iterator<char>(cin), istreambuf_iterator<char>()));
+        if (optimize) {
+            request.add("optimize", "1");
+        }
+    } else {
+        request.add("type", "compile");
+        request.add("cwd", currentDir);
+        for (const string& arg : args) {
+            request.add("arg", arg);
+        }
+    }
+
+    int fd = connect_socket(socketPath);
+    if (fd < 0) {
+        if (shutdown) {
+            cerr << "Nenhum servidor em " << socketPath << endl;
+            return 1;
+        }
+        if (fromStdin) {
+            cerr << "Servidor indisponivel em " << socketPath << endl;
+            return 1;
+        }
+        return run_locally(args);
+    }
+
+    // Um socket de outro usuário receberia o fonte e responderia o que quisesse.
+    if (!peer_is_owner(fd)) {
+        cerr << "O servidor em " << socketPath << " pertence a outro usuario" << endl;
+        close(fd);
+        return 1;
+    }
+
+    Message response;
+    try {
+        send_message(fd, request);
+        if (!receive_message(fd, response)) {
+            throw runtime_error("conexao encerrada pelo servidor");
+        }
+    } catch (const exception& e) {
+        cerr << "Erro na comunicacao com o servidor: " << e.what() << endl;
+        close(fd);
+        return 1;
+    }
+    close(fd);
+
+    string output = response.get(fromStdin ? "words" : "out");
+    // O .o2 é uma linha sem '\n' final; no terminal ela termina a linha.
+    if (fromStdin && !output.empty() && output.back() != '\n') {
+        output += '\n';
+    }
+    cout << output;
+    cerr << response.get(fromStdin ? "diagnostics" : "err");
+    cout.flush();
+    return atoi(response.get("status", "1").c_str());
+}
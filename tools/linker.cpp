@@ -0,0 +1,84 @@
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Linker.hpp"
+#include "ObjectFile.hpp"
+#include "Parallel.hpp"
+
+using namespace std;
+
+void print_usage(const char* program) {
+    cerr << "Uso: " << program << " [-o saida.obj|saida.o2] [-j N] modulo.obj..." << endl;
+}
+
+bool ends_with(const string& text, const string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Liga módulos montados com --binary (.obj com tabelas de definições, de uso e
+// relocações) num único programa. A saída é um .obj (binário) ou, com outra
+// extensão, o texto do .o2; o primeiro módulo é carregado no endereço 0.
+int main(int argc, char* argv[]) {
+    string output = "ligado.obj";
+    unsigned jobs = thread::hardware_concurrency();
+    vector<string> inputs;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "-o" && i + 1 < argc) {
+            output = argv[++i];
+        } else if (arg.rfind("-j", 0) == 0) {
+            string value = arg.size() > 2 ? arg.substr(2) : (i + 1 < argc ? argv[++i] : string());
+            try {
+                jobs = static_cast<unsigned>(stoul(value));
+            } catch (const exception&) {
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (!arg.empty() && arg[0] != '-') {
+            inputs.push_back(arg);
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (inputs.empty()) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    try {
+        vector<ObjectImage> modules(inputs.size());
+        parallel_for(inputs.size(), jobs, [&](size_t i) {
+            if (!ends_with(inputs[i], ".obj"))
+                throw runtime_error("O ligador le apenas objetos binarios (.obj, monte com --binary): " + inputs[i]);
+            modules[i] = read_binary_object(inputs[i]);
+        });
+
+        LinkResult result = link_objects(modules, inputs, jobs);
+        if (!result.ok()) {
+            for (const string& error : result.errors) {
+                cerr << error << "\n";
+            }
+            cerr << "Ligacao falhou: " << result.errors.size() << " erro(s)." << endl;
+            return 1;
+        }
+
+        if (ends_with(output, ".obj")) {
+            write_binary_object(output, result.image);
+        } else {
+            ofstream file(output, ios::binary);
+            if (!file.is_open()) {
+                throw runtime_error("Erro ao abrir o arquivo de saida: " + output);
+            }
+            write_text_object(file, result.image.words);
+        }
+        cout << inputs.size() << " modulo(s), " << result.image.words.size() << " word(s) -> " << output << endl;
+        return 0;
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+}
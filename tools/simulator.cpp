@@ -0,0 +1,103 @@
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include "Loader.hpp"
+#include "ObjectFile.hpp"
+#include "Simulator.hpp"
+
+using namespace std;
+
+void print_usage(const char* program) {
+    cerr << "Uso: " << program << " [--input ARQ] [--max-steps N] [--base N] [--quiet] programa.o2|programa.obj" << endl;
+}
+
+// Executa uma imagem gerada pelo montador. A entrada do programa (INPUT) vem
+// de stdin ou de --input; a saída (OUTPUT) vai para stdout e o relatório de
+// desempenho para stderr.
+int main(int argc, char* argv[]) {
+    string program;
+    string inputFile;
+    uint64_t maxSteps = 0;
+    int base = 0;
+    bool quiet = false;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--input" && i + 1 < argc) {
+            inputFile = argv[++i];
+        } else if (arg == "--max-steps" && i + 1 < argc) {
+            try {
+                maxSteps = stoull(argv[++i]);
+            } catch (const exception&) {
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--base" && i + 1 < argc) {
+            // Carrega o .obj a partir deste endereço (relocado pelo mapa do objeto).
+            try {
+                base = stoi(argv[++i]);
+            } catch (const exception&) {
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--quiet") {
+            quiet = true;
+        } else if (!arg.empty() && arg[0] != '-' && program.empty()) {
+            program = arg;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (program.empty()) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    ios::sync_with_stdio(false);
+    try {
+        // .obj: formato binário; qualquer outro: texto (.o2).
+        bool binary = program.size() > 4 && program.compare(program.size() - 4, 4, ".obj") == 0;
+        vector<int> words;
+        int entryPoint = 0;
+        if (binary) {
+            vector<ObjectImage> images(1, read_binary_object(program));
+            if (images[0].hasUnresolved()) {
+                cerr << "Objeto com pendencias nao resolvidas: " << program << endl;
+                return 1;
+            }
+            entryPoint = load_images(images, words, base)[0].entryPoint;
+        } else if (base != 0) {
+            cerr << "--base exige um objeto binario (.obj), que tem o mapa de relocacao." << endl;
+            return 1;
+        } else {
+            words = read_text_object(program);
+        }
+
+        unique_ptr<ifstream> file;
+        istream* in = &cin;
+        if (!inputFile.empty()) {
+            file = make_unique<ifstream>(inputFile);
+            if (!file->is_open()) {
+                cerr << "Nao foi possivel abrir a entrada: " << inputFile << endl;
+                return 1;
+            }
+            in = file.get();
+        }
+
+        Simulator simulator(std::move(words), entryPoint);
+        SimulationResult result = simulator.run(*in, cout, maxSteps);
+        if (!quiet) {
+            cerr << result.instructions << " instrucoes em " << result.seconds << " s ("
+                 << result.instructions_per_second() / 1e6 << " milhoes/s)"
+                 << (result.halted ? "" : " - limite de passos atingido") << endl;
+        }
+        return result.halted ? 0 : 2;
+    } catch (const exception& e) {
+        cout.flush();
+        cerr << e.what() << endl;
+        return 1;
+    }
+}